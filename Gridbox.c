@@ -100,7 +100,9 @@
  * getPreferredSizes()	obtains preferred sizes from child widgets.
  * computeWidHgtInfo()	based on preferred sizes, find row/column sizes
  * computeWidHgtMax()	based on preferred sizes, find max sizes
+ * updateTracks()	adjust max sizes for children managed or unmanaged
  * GridboxResize()	given Gridbox size, lay out the child widgets.
+ * reportLayout()	tell layoutCallback which children were moved
  * layout()		given size, assign sizes of rows & columns
  * layoutChild()	assign size of one child widget
  * changeGeometry()	attempt to change size, negotiate with parent
@@ -108,19 +110,88 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef	GRIDBOX_PROBES
+#include <sys/sdt.h>
+#endif
 
 #include <X11/IntrinsicP.h>
 #include <X11/StringDefs.h>
+#include <X11/Xmd.h>
 #include <X11/Xmu/Converters.h>
 #include <X11/Xmu/CharSet.h>
 #include "GridboxP.h"
 
 #define DEFAULT_MARGIN	-1
 
+	/* Keyword tables for the converters, in lower case. */
+
+typedef	struct {
+    String	name ;
+    FillType	value ;
+    Position	position ;
+} Keyword ;
+
+#define	MAX_KEYWORD	15	/* longest keyword */
+
+static	Keyword	fillKeywords[] = {
+    {"none", FillNone},
+    {"fillnone", FillNone},
+    {"width", FillWidth},
+    {"fillwidth", FillWidth},
+    {"horizontal", FillWidth},
+    {"x", FillWidth},
+    {"height", FillHeight},
+    {"fillheight", FillHeight},
+    {"vertical", FillHeight},
+    {"y", FillHeight},
+    {"both", FillBoth},
+    {"fillboth", FillBoth},
+    {"all", FillBoth},
+    {"xy", FillBoth},
+} ;
+
+static	Keyword	positionKeywords[] = {
+    {"gridboxnext", 0, GRIDBOX_NEXT},
+    {"gridnext", 0, GRIDBOX_NEXT},
+    {"next", 0, GRIDBOX_NEXT},
+    {"gridboxsame", 0, GRIDBOX_SAME},
+    {"gridsame", 0, GRIDBOX_SAME},
+    {"same", 0, GRIDBOX_SAME},
+} ;
+
+
 #define Offset(field) XtOffsetOf(GridboxRec, gridbox.field)
 static XtResource resources[] = {
     {XtNdefaultDistance, XtCThickness, XtRInt, sizeof(int),
 	Offset(defaultDistance), XtRImmediate, (XtPointer)4},
+    {XtNhomogeneous, XtCHomogeneous, XtRBoolean, sizeof(Boolean),
+	Offset(homogeneous), XtRImmediate, (XtPointer)False},
+    {XtNcolumnSpec, XtCTrackSpec, XtRString, sizeof(String),
+	Offset(columnSpec), XtRImmediate, (XtPointer)NULL},
+    {XtNrowSpec, XtCTrackSpec, XtRString, sizeof(String),
+	Offset(rowSpec), XtRImmediate, (XtPointer)NULL},
+    {XtNlayoutCacheFile, XtCFile, XtRString, sizeof(String),
+	Offset(layoutCacheFile), XtRImmediate, (XtPointer)NULL},
+    {XtNtraceFile, XtCFile, XtRString, sizeof(String),
+	Offset(traceFile), XtRImmediate, (XtPointer)NULL},
+    {XtNlayoutCallback, XtCCallback, XtRCallback, sizeof(XtCallbackList),
+	Offset(layoutCallback), XtRCallback, (XtPointer)NULL},
+    {XtNpublishLayout, XtCPublishLayout, XtRBoolean, sizeof(Boolean),
+	Offset(publishLayout), XtRImmediate, (XtPointer)False},
+    {XtNpreserveContents, XtCPreserveContents, XtRBoolean, sizeof(Boolean),
+	Offset(preserveContents), XtRImmediate, (XtPointer)False},
+    {XtNbatchConfigure, XtCBatchConfigure, XtRBoolean, sizeof(Boolean),
+	Offset(batchConfigure), XtRImmediate, (XtPointer)False},
 };
 #undef Offset
 
@@ -160,6 +231,7 @@ static	XtGeometryResult
 	  GridboxQueryGeometry(Widget, XtWidgetGeometry *, XtWidgetGeometry *) ;
 
 static	void	GridboxChangeManaged(Widget w) ;
+static	void	GridboxDeleteChild(Widget w) ;
 static	XtGeometryResult
 	GridboxGeometryManager(Widget, XtWidgetGeometry *, XtWidgetGeometry *) ;
 
@@ -168,20 +240,96 @@ static	Boolean
 	GridboxConstraintSetValues(Widget, Widget, Widget, ArgList, Cardinal *);
 
 
-static	void	getPreferredSizes(GridboxWidget) ;
+static	void	getPreferredSizes(GridboxWidget, Bool) ;
 static	void	computeCellSize(GridboxWidget, GridboxConstraints,
-			Dimension *,Dimension *);
-static	void	allocAll(GridboxWidget) ;
+			int *, int *);
+static	void	allocAll(GridboxWidget, int, int) ;
 static	void	freeAll(GridboxWidget) ;
+static	void	applyRects(GridboxWidget, GridboxRect *) ;
+static	int	moveCompare(const void *, const void *) ;
+static	GridboxWidget growScratch(GridboxWidget) ;
+static	void	countExpose(Widget, XtPointer, XEvent *, Boolean *) ;
+static	Bool	isMapped(Widget) ;
+static	void	forgetContents(GridboxWidget) ;
+static	Bool	dormant(GridboxWidget) ;
+static	Bool	withdrawn(GridboxWidget) ;
+static	void	catchUp(GridboxWidget) ;
+static	void	visibilityChange(Widget, XtPointer, XEvent *, Boolean *) ;
+static	void	redisplayGadgets(GridboxWidget, XEvent *, Region) ;
+static	void	collectGadgets(GridboxWidget) ;
+static	int	gadgetCompare(const void *, const void *) ;
+static	int	rowAt(GridboxWidget, int) ;
+static	GridboxRect *saveGeometry(GridboxWidget) ;
+static	void	reportLayout(GridboxWidget, GridboxRect *) ;
+static	GridboxLayout *buildLayout(GridboxWidget) ;
+static	void	linearTracks(int, int *, int *, int, int, int *, int *) ;
+static	void	publishLayout(GridboxWidget, Bool) ;
+static	void	reapLayouts(GridboxWidget, Bool) ;
+static	Boolean	reapLater(XtPointer) ;
+static	GridboxCacheEntry *cacheFind(GridboxWidget) ;
+static	GridboxCacheEntry *cacheNew(GridboxWidget) ;
+static	void	cacheFree(GridboxWidget) ;
 static	void	computeWidHgtInfo(GridboxWidget) ;
 static	void	computeWidHgtMax(GridboxWidget) ;
-static	void	computeWidHgtUtil(int, int, int, int, Dimension *, int *) ;
+static	void	computeUniformMax(GridboxWidget) ;
+static	void	computeTotals(GridboxWidget) ;
+static	void	computeSums(GridboxWidget) ;
+static	Bool	updateTracks(GridboxWidget, Widget) ;
+static	void	computeWidHgtUtil(int, int, int, int, int *, int *) ;
+static	int	fixedSize(GridboxTrack *, int, int, int) ;
+static	void	clampTracks(GridboxTrack *, int, int *, int) ;
+static	void	parseTrackSpec(String, GridboxTrack **, int *) ;
+static	void	setTrack(GridboxWidget, GridboxTrack **, int *,
+			int, int, int, int) ;
+static	void	relayout(GridboxWidget) ;
+static	void	fitToGrid(GridboxWidget) ;
+static	void	shiftTracks(GridboxWidget, Bool, int, int) ;
+static	Bool	spliceTracks(GridboxWidget, Bool, int, int) ;
+static	GridboxTrack *extendTracks(GridboxTrack **, int *, int) ;
+static	void	collapseTrack(GridboxWidget, Bool, int, Bool) ;
+static	Bool	collapsedSpan(GridboxTrack *, int, int, int) ;
+static	void	showChildren(GridboxWidget) ;
+static	void	groupJoin(GridboxWidget, Bool, GridboxGroup) ;
+static	void	groupPublish(GridboxWidget, Bool) ;
+static	void	groupContribute(GridboxGroup, GridboxWidget, Bool,
+			int *, int) ;
+static	Boolean	groupLayout(XtPointer) ;
+static	void	groupRestore(GridboxWidget) ;
+static	unsigned long	layoutHash(GridboxWidget, int *) ;
+static	Bool	loadPrefs(GridboxWidget) ;
+static	void	savePrefs(GridboxWidget) ;
+static	Boolean	validatePrefs(XtPointer) ;
+static	XtGeometryResult
+	geometryManager(Widget, XtWidgetGeometry *, XtWidgetGeometry *) ;
+static	XtGeometryResult
+	queryGeometry(Widget, XtWidgetGeometry *, XtWidgetGeometry *) ;
+static	void	changeManaged(Widget) ;
+static	void	resizeChildren(Widget) ;
+static	void	traceOpen(GridboxWidget) ;
+static	void	traceClose(GridboxWidget) ;
+static	unsigned long	traceTime(GridboxWidget) ;
+static	void	traceRecord(GridboxWidget, int, Widget, int *, int) ;
+static	void	traceChild(GridboxWidget, int, Widget) ;
+static	int	constrainedSize(GridboxWidget, Bool, int) ;
 static	void	layout(GridboxWidget, int, int) ;
-static	void	layoutChild(GridboxWidget, Widget, Dimension *, Dimension *,
-			Position *, Position *) ;
+static	void	uniformAxis(int, int, int, int, int, int *, int *) ;
+static	void	layoutAxis(int, int *, int *, int, int, int,
+			GridboxTrack *, int, int *) ;
+static	void	computeSlopes(GridboxWidget) ;
+static	Bool	linearLayout(GridboxWidget) ;
+static	void	placeChild(Widget, int, int, int *, int *, int *, int *) ;
+static	Bool	fitsTracks(GridboxWidget, GridboxConstraints, int, int) ;
+static	Bool	fitsAxis(int *, int, GridboxTrack *, int,
+			int, int, int, int) ;
+static	void	cellOrigin(GridboxWidget, GridboxConstraints, int *, int *) ;
+static	void	moveChild(GridboxWidget, Widget, int, int, int, int) ;
+static	void	layoutChild(GridboxWidget, Widget, int *, int *, int *, int *) ;
 static	XtGeometryResult
 	      changeGeometry(GridboxWidget, int, int, int, XtWidgetGeometry *) ;
+static	XtGeometryResult
+	      refuseRequest(GridboxWidget, GridboxConstraints, int, int, Bool) ;
 
+static	Keyword	*findKeyword(String, Keyword *, int) ;
 static	Boolean _CvtStringToFillType(Display *, XrmValuePtr, Cardinal *,
 			XrmValuePtr, XrmValuePtr, XtPointer *) ;
 static	Boolean _CvtStringToGridPosition(Display *, XrmValuePtr, Cardinal *,
@@ -194,29 +342,157 @@ static	void	GridboxResize() ;
 static	Boolean GridboxSetValues() ;
 static	void	GridboxDestroy() ;
 static	void	GridboxChangeManaged() ;
+static	void	GridboxDeleteChild() ;
 static	void	GridboxConstraintInit() ;
 static	Boolean GridboxConstraintSetValues() ;
 static	void	getPreferredSizes() ;
 static	void	computeCellSize() ;
+static	void	allocAll() ;
 static	void	freeAll() ;
+static	void	applyRects() ;
+static	int	moveCompare() ;
+static	GridboxWidget growScratch() ;
+static	void	countExpose() ;
+static	Bool	isMapped() ;
+static	void	forgetContents() ;
+static	Bool	dormant() ;
+static	Bool	withdrawn() ;
+static	void	catchUp() ;
+static	void	visibilityChange() ;
+static	void	redisplayGadgets() ;
+static	void	collectGadgets() ;
+static	int	gadgetCompare() ;
+static	int	rowAt() ;
+static	GridboxRect *saveGeometry() ;
+static	void	reportLayout() ;
+static	GridboxLayout *buildLayout() ;
+static	void	linearTracks() ;
+static	void	publishLayout() ;
+static	void	reapLayouts() ;
+static	Boolean	reapLater() ;
+static	GridboxCacheEntry *cacheFind() ;
+static	GridboxCacheEntry *cacheNew() ;
+static	void	cacheFree() ;
 static	void	computeWidHgtInfo() ;
+static	void	computeWidHgtMax() ;
+static	void	computeUniformMax() ;
+static	void	computeTotals() ;
+static	void	computeSums() ;
+static	Bool	updateTracks() ;
 static	void	computeWidHgtUtil() ;
+static	int	fixedSize() ;
+static	void	clampTracks() ;
+static	void	parseTrackSpec() ;
+static	void	setTrack() ;
+static	void	relayout() ;
+static	void	fitToGrid() ;
+static	void	shiftTracks() ;
+static	Bool	spliceTracks() ;
+static	GridboxTrack *extendTracks() ;
+static	void	collapseTrack() ;
+static	Bool	collapsedSpan() ;
+static	void	showChildren() ;
+static	void	groupJoin() ;
+static	void	groupPublish() ;
+static	void	groupContribute() ;
+static	Boolean	groupLayout() ;
+static	void	groupRestore() ;
+static	unsigned long	layoutHash() ;
+static	Bool	loadPrefs() ;
+static	void	savePrefs() ;
+static	Boolean	validatePrefs() ;
+static	XtGeometryResult	geometryManager() ;
+static	XtGeometryResult	queryGeometry() ;
+static	int	constrainedSize() ;
+static	void	changeManaged() ;
+static	void	resizeChildren() ;
+static	void	traceOpen() ;
+static	void	traceClose() ;
+static	unsigned long	traceTime() ;
+static	void	traceRecord() ;
+static	void	traceChild() ;
 static	void	layout() ;
+static	void	uniformAxis() ;
+static	void	layoutAxis() ;
+static	void	computeSlopes() ;
+static	Bool	linearLayout() ;
+static	void	placeChild() ;
+static	Bool	fitsTracks() ;
+static	Bool	fitsAxis() ;
+static	void	cellOrigin() ;
+static	void	moveChild() ;
 static	void	layoutChild() ;
 static	XtGeometryResult	GridboxQueryGeometry() ;
 static	XtGeometryResult	GridboxGeometryManager() ;
 static	XtGeometryResult	changeGeometry() ;
+static	XtGeometryResult	refuseRequest() ;
+static	Keyword	*findKeyword() ;
 static	Boolean _CvtStringToFillType() ;
 static	Boolean _CvtStringToGridPosition() ;
 #endif
 
+	/* nesting depth of traced geometry calls; see traceRecord().
+	 * Nesting happens within one thread, so each thread counts its own.
+	 * Other compilers get one count for all threads; the depths in
+	 * trace files are then wrong while several threads trace at once.
+	 */
+#if defined(__GNUC__)
+static	__thread int	traceDepth = 0 ;
+#else
+static	int	traceDepth = 0 ;
+#endif
+
+	/* The public functions may be called by any thread which has not
+	 * already locked the widget's application context; the class
+	 * methods are called by Xt with it locked.  Both do nothing unless
+	 * XtToolkitThreadInitialize() has been called.
+	 */
+#define	LockWidget(w)	XtAppLock(XtWidgetToApplicationContext(w))
+#define	UnlockWidget(w)	XtAppUnlock(XtWidgetToApplicationContext(w))
+
 #define XTCALLOC(n,type)	((type *) XtCalloc((n), sizeof(type)))
 
+	/* Static probes at the start and end of each layout phase, for
+	 * system-wide tracers such as bpftrace or perf; see gridbox.bt.
+	 * Compiled in with -DGRIDBOX_PROBES where <sys/sdt.h> exists; each
+	 * is a no-op instruction until a tracer attaches to it.
+	 */
+#ifdef	GRIDBOX_PROBES
+#define	PROBE3(n,a,b,c)		DTRACE_PROBE3(gridbox, n, a, b, c)
+#define	PROBE4(n,a,b,c,d)	DTRACE_PROBE4(gridbox, n, a, b, c, d)
+#define	PROBE5(n,a,b,c,d,e)	DTRACE_PROBE5(gridbox, n, a, b, c, d, e)
+#else
+#define	PROBE3(n,a,b,c)
+#define	PROBE4(n,a,b,c,d)
+#define	PROBE5(n,a,b,c,d,e)
+#endif
+
+	/* Sizes are computed in ints, and only cut down to size when
+	 * handed to Xt.
+	 */
+#define	MAX_DIMENSION	0xffff
+#define	MAX_POSITION	0x7fff
+#define	MIN_POSITION	(-0x8000)
+#define	ToDimension(v)	((Dimension) ((v) < 0 ? 0 : \
+				(v) > MAX_DIMENSION ? MAX_DIMENSION : (v)))
+#define	ToPosition(v)	((Position) ((v) < MIN_POSITION ? MIN_POSITION : \
+				(v) > MAX_POSITION ? MAX_POSITION : (v)))
+
 #ifndef min
 #define min(a,b)	((a)<(b)?(a):(b))
 #define max(a,b)	((a)>(b)?(a):(b))
 #endif
 
+	/* Edges of the cells of a uniform grid.  The excess space is
+	 * shared out as layoutAxis() does with equal weights, so every
+	 * pixel is used and a uniform grid comes out the same as any
+	 * other.
+	 */
+#define	ColumnEdge(gb,i)	((i) * (gb)->gridbox.cell_wid + \
+		(i) * (gb)->gridbox.cell_xspare / max((gb)->gridbox.nx,1))
+#define	RowEdge(gb,i)		((i) * (gb)->gridbox.cell_hgt + \
+		(i) * (gb)->gridbox.cell_yspare / max((gb)->gridbox.ny,1))
+
 
 #ifdef	DEBUG
 #define assert(e)	do { if( !(e) ) assfail(#e,__LINE__);} while(0)
@@ -226,10 +502,18 @@ assfail(char *e, int line)
   fprintf(stderr, "yak! assertion failed: %s, %s line %d\n",
     e, __FILE__, line) ;
 }
+static	void	checkLayout() ;
 #else
 #define assert(e)
 #endif
 
+	/* Depth of nested geometry requests from our children beyond
+	 * which they are refused.  A child which asks again from within
+	 * its own resize, or nested Gridboxes which keep rounding each
+	 * other's sizes up, would otherwise negotiate forever.
+	 */
+#define	MAX_NEGOTIATION	8
+
 
 
 
@@ -258,7 +542,7 @@ GridboxClassRec gridboxClassRec = {
     /* compress_motion	  */	TRUE,
     /* compress_exposure  */	TRUE,
     /* compress_enterleave*/	TRUE,
-    /* visible_interest	  */	FALSE,
+    /* visible_interest	  */	TRUE,
     /* destroy		  */	GridboxDestroy,
     /* resize		  */	GridboxResize,
     /* expose		  */	GridboxExpose,
@@ -278,7 +562,7 @@ GridboxClassRec gridboxClassRec = {
     /* geometry_manager	  */   GridboxGeometryManager,
     /* change_managed	  */   GridboxChangeManaged,
     /* insert_child	  */   XtInheritInsertChild,
-    /* delete_child	  */   XtInheritDeleteChild,
+    /* delete_child	  */   GridboxDeleteChild,
     /* extension	  */   NULL
   },
   { /* constraint_class fields */
@@ -320,10 +604,12 @@ static	void
 GridboxClassInit()
 {
     XtAddConverter( XtRString, XtRGravity, XmuCvtStringToGravity, NULL, 0) ;
+
+    /* Results depend only on the string, so let Xt cache them */
     XtSetTypeConverter( XtRString, XtRFillType, _CvtStringToFillType,
-	NULL, 0, XtCacheNone, (XtDestructor)NULL);
+	NULL, 0, XtCacheAll, (XtDestructor)NULL);
     XtSetTypeConverter( XtRString, XtRGridPosition, _CvtStringToGridPosition,
-	NULL, 0, XtCacheNone, (XtDestructor)NULL);
+	NULL, 0, XtCacheAll, (XtDestructor)NULL);
 }
 
 
@@ -337,26 +623,82 @@ GridboxInit(request, new, args, num_args)
     GridboxWidget gb = (GridboxWidget)new;
 
     gb->gridbox.nx = gb->gridbox.ny = 0 ;
+    gb->gridbox.nx_alloc = gb->gridbox.ny_alloc = 0 ;
+    gb->gridbox.nhidden = 0 ;
+    gb->gridbox.colgroup = gb->gridbox.rowgroup = NULL ;
+    gb->gridbox.group_wids = gb->gridbox.group_hgts = NULL ;
+    gb->gridbox.group_nx = gb->gridbox.group_ny = 0 ;
+    gb->gridbox.group_dirty = False ;
     gb->gridbox.max_wids = gb->gridbox.max_hgts = NULL ;
     gb->gridbox.wids = gb->gridbox.hgts = NULL ;
     gb->gridbox.total_wid = gb->gridbox.total_hgt = 0 ;
     gb->gridbox.max_weightx = gb->gridbox.max_weighty = NULL ;
+    gb->gridbox.col_tracks = gb->gridbox.row_tracks = NULL ;
+    gb->gridbox.ncol_tracks = gb->gridbox.nrow_tracks = 0 ;
+    gb->gridbox.uniform = False ;
+    gb->gridbox.uniform_wid = gb->gridbox.uniform_hgt = 0 ;
+    gb->gridbox.cell_wid = gb->gridbox.cell_hgt = 0 ;
+    gb->gridbox.cell_xspare = gb->gridbox.cell_yspare = 0 ;
     gb->gridbox.needs_layout = True ;
+    gb->gridbox.generation = 1 ;
+    gb->gridbox.slope_generation = 0 ;
+    gb->gridbox.linear_ok = False ;
+    gb->gridbox.tracks_stale = False ;
+    gb->gridbox.cache_clock = 0 ;
+    memset(gb->gridbox.cache, 0, sizeof(gb->gridbox.cache)) ;
+    memset(&gb->gridbox.stats, 0, sizeof(gb->gridbox.stats)) ;
+
+    if( gb->gridbox.columnSpec != NULL )
+      gb->gridbox.columnSpec = XtNewString(gb->gridbox.columnSpec) ;
+    if( gb->gridbox.rowSpec != NULL )
+      gb->gridbox.rowSpec = XtNewString(gb->gridbox.rowSpec) ;
+    if( gb->gridbox.layoutCacheFile != NULL )
+      gb->gridbox.layoutCacheFile = XtNewString(gb->gridbox.layoutCacheFile);
+    if( gb->gridbox.traceFile != NULL )
+      gb->gridbox.traceFile = XtNewString(gb->gridbox.traceFile) ;
+    gb->gridbox.saved_state = SAVED_NONE ;
+    gb->gridbox.saved_loaded = False ;
+    gb->gridbox.saved_proc = (XtWorkProcId)0 ;
+    gb->gridbox.trace = NULL ;
+    gb->gridbox.snapshot = gb->gridbox.snap_retired = NULL ;
+    gb->gridbox.snap_readers = 0 ;
+    gb->gridbox.snap_serial = 0 ;
+    gb->gridbox.reap_proc = (XtWorkProcId)0 ;
+    gb->gridbox.scratch_rects = NULL ;
+    gb->gridbox.moves = NULL ;
+    gb->gridbox.scratch_alloc = 0 ;
+    gb->gridbox.gadgets = NULL ;
+    gb->gridbox.ngadgets = gb->gridbox.gadgets_alloc = 0 ;
+    gb->gridbox.gadget_generation = 0 ;
+    gb->gridbox.obscured = gb->gridbox.unmapped = False ;
+    gb->gridbox.dormant_dirty = False ;
+    gb->gridbox.negotiating = 0 ;
+    XtAddEventHandler(new, VisibilityChangeMask|StructureNotifyMask, False,
+	visibilityChange, (XtPointer)gb) ;
+    XtAddEventHandler(new, ExposureMask, False, countExpose, (XtPointer)gb) ;
+    if( gb->gridbox.traceFile != NULL )
+      traceOpen(gb) ;
+    parseTrackSpec(gb->gridbox.columnSpec,
+	&gb->gridbox.col_tracks, &gb->gridbox.ncol_tracks) ;
+    parseTrackSpec(gb->gridbox.rowSpec,
+	&gb->gridbox.row_tracks, &gb->gridbox.nrow_tracks) ;
 
     /* TODO: I think that there are no children at this point, so there's
      * really no point in doing any geometry management now.  All of
      * this code may be unnecessary.
      */
 
-    getPreferredSizes(gb) ;
+    getPreferredSizes(gb, False) ;
 
     if( request->core.width == 0 || request->core.height == 0 )
     {
       if( gb->gridbox.max_wids == NULL )
 	computeWidHgtInfo(gb) ;
 
-      if( request->core.width == 0 ) new->core.width = gb->gridbox.total_wid;
-      if( request->core.height == 0 ) new->core.height = gb->gridbox.total_hgt;
+      if( request->core.width == 0 )
+	new->core.width = ToDimension(gb->gridbox.total_wid) ;
+      if( request->core.height == 0 )
+	new->core.height = ToDimension(gb->gridbox.total_hgt) ;
     }
 
     /* TODO: resize now, or wait until later? */
@@ -376,8 +718,8 @@ GridboxExpose(w, event, region)
 {
 	GridboxWidget gb = (GridboxWidget)w ;
 
-	if( gb->gridbox.needs_layout )
-	  XtClass(w)->core_class.resize(w) ;
+	catchUp(gb) ;
+	redisplayGadgets(gb, event, region) ;
 }
 
 
@@ -385,17 +727,69 @@ GridboxExpose(w, event, region)
 static	void
 GridboxResize(w)
     Widget w;
+{
+    GridboxWidget	gb = (GridboxWidget)w;
+    GridboxRect		*old = NULL ;
+    unsigned long	t0 ;
+    int			args[3] ;
+
+    if( dormant(gb) ) {
+      gb->gridbox.needs_layout = True ;
+      return ;
+    }
+
+    PROBE4(resize_start, gb, gb->composite.num_children,
+	gb->core.width, gb->core.height) ;
+
+    if( XtHasCallbacks(w, XtNlayoutCallback) == XtCallbackHasSome )
+      old = saveGeometry(gb) ;
+
+    if( gb->gridbox.trace == NULL )
+      resizeChildren(w) ;
+    else
+    {
+      t0 = traceTime(gb) ;
+      ++traceDepth ;
+      resizeChildren(w) ;
+      --traceDepth ;
+      args[0] = gb->core.width ;
+      args[1] = gb->core.height ;
+      args[2] = traceTime(gb) - t0 ;
+      traceRecord(gb, GBT_RESIZE, NULL, args, 3) ;
+    }
+#ifdef	DEBUG
+    checkLayout(gb) ;
+#endif
+
+    showChildren(gb) ;
+
+    if( gb->gridbox.publishLayout )
+      publishLayout(gb, True) ;
+
+    if( old != NULL )
+      reportLayout(gb, old) ;
+
+    PROBE4(resize_done, gb, gb->composite.num_children,
+	gb->gridbox.nx, gb->gridbox.ny) ;
+}
+
+
+static	void
+resizeChildren(w)
+    Widget w;
 {
     GridboxWidget gb = (GridboxWidget)w;
     WidgetList children = gb->composite.children;
     int num_children = gb->composite.num_children;
     Widget	*childP;
-    Position	x, y;
-    Dimension	width, height;
+    int		x, y;
+    int		width, height;
     int		i ;
     int		margin ;
-    Dimension	*wids, *hgts ;
-    Position	*xs, *ys ;
+    int		*wids, *hgts ;
+    int		*xs, *ys ;
+    GridboxCacheEntry *entry ;
+    GridboxRect	*rect ;
 
     /* determine how much space the rows & columns need */
 
@@ -405,12 +799,67 @@ GridboxResize(w)
     if( gb->gridbox.nx <= 0 || gb->gridbox.ny <= 0 )
       return ;
 
+    /* Been here before? */
+    if( (entry = cacheFind(gb)) != NULL )
+    {
+      ++gb->gridbox.stats.cache_hits ;
+      if( !gb->gridbox.uniform ) {
+	memcpy(gb->gridbox.wids, entry->wids, entry->nx * sizeof(int)) ;
+	memcpy(gb->gridbox.hgts, entry->hgts, entry->ny * sizeof(int)) ;
+      }
+      gb->gridbox.cell_wid = entry->cell_wid ;
+      gb->gridbox.cell_hgt = entry->cell_hgt ;
+      gb->gridbox.cell_xspare = entry->cell_xspare ;
+      gb->gridbox.cell_yspare = entry->cell_yspare ;
+      applyRects(gb, entry->rects) ;
+      gb->gridbox.needs_layout = False ;
+      return ;
+    }
+    ++gb->gridbox.stats.cache_misses ;
+
+    /* Only our size has changed since the last time? */
+    if( linearLayout(gb) ) {
+      ++gb->gridbox.stats.linear_layouts ;
+      gb->gridbox.needs_layout = False ;
+      return ;
+    }
+
     /* assign row & column sizes */
     layout(gb, gb->core.width, gb->core.height) ;
 
+    entry = cacheNew(gb) ;
+    rect = entry->rects ;
+
+    /* Uniform grid; every cell is the same size, so the position of
+     * each child can be computed directly from its grid position.
+     */
+    if( gb->gridbox.uniform )
+    {
+      for (childP = children; childP - children < num_children; childP++)
+	if( XtIsManaged(*childP) )
+	{
+	  GridboxConstraints gc =
+	  	(GridboxConstraints)(*childP)->core.constraints;
+
+	  margin = gc->gridbox.margin ;
+	  x = ColumnEdge(gb, gc->gridbox.gridx) + margin ;
+	  y = RowEdge(gb, gc->gridbox.gridy) + margin ;
+
+	  layoutChild(gb, *childP, &width, &height, &x, &y) ;
+
+	  rect->x = ToPosition(x) ; rect->y = ToPosition(y) ;
+	  rect->width = ToDimension(width) ; rect->height = ToDimension(height) ;
+	  ++rect ;
+	}
+      entry->nchild = rect - entry->rects ;
+      applyRects(gb, entry->rects) ;
+      gb->gridbox.needs_layout = False ;
+      return ;
+    }
+
     /* assign positions */
     wids =  gb->gridbox.wids ;
-    xs =  XTCALLOC(gb->gridbox.nx, Position) ;
+    xs =  XTCALLOC(gb->gridbox.nx, int) ;
     for(x=0, i=0; i < gb->gridbox.nx; ++i)
     {
       xs[i] = x ;
@@ -419,7 +868,7 @@ GridboxResize(w)
 
     /* Same again, for heights */
     hgts = gb->gridbox.hgts ;
-    ys = XTCALLOC(gb->gridbox.ny, Position) ;
+    ys = XTCALLOC(gb->gridbox.ny, int) ;
     for(y=0, i=0; i < gb->gridbox.ny; ++i)
     {
       ys[i] = y ;
@@ -435,7 +884,6 @@ GridboxResize(w)
       if( XtIsManaged(*childP) )
       {
 	GridboxConstraints gc = (GridboxConstraints)(*childP)->core.constraints;
-	if (!XtIsManaged(*childP)) continue;
 
 	margin = gc->gridbox.margin ;
 	x = xs[gc->gridbox.gridx] + margin ;
@@ -443,15 +891,275 @@ GridboxResize(w)
 
 	layoutChild(gb, *childP, &width, &height, &x, &y) ;
 
-	XtConfigureWidget(*childP,x,y, width, height,
-	  (*childP)->core.border_width );
+	rect->x = ToPosition(x) ; rect->y = ToPosition(y) ;
+	rect->width = ToDimension(width) ; rect->height = ToDimension(height) ;
+	++rect ;
       }
+    entry->nchild = rect - entry->rects ;
+    applyRects(gb, entry->rects) ;
     gb->gridbox.needs_layout = False ;
     XtFree((char *)xs) ;
     XtFree((char *)ys) ;
 }
 
 
+	/* Configure the managed children to the given rectangles */
+
+static	void
+applyRects(gb, rects)
+    GridboxWidget	gb ;
+    GridboxRect		*rects ;
+{
+    WidgetList	children = gb->composite.children;
+    int		num_children = gb->composite.num_children;
+    Widget	*childP;
+    GridboxRect	*rect ;
+    GridboxMove	*moves, *move ;
+    GridboxConstraints	gc ;
+    XSetWindowAttributes attr ;
+    Bool	batch ;
+    int		n ;
+
+    /* Find the children which actually change, and sort them so that
+     * none is moved on top of a neighbour which hasn't moved out of
+     * the way yet:  first those moving towards the origin or shrinking,
+     * nearest first, then the rest, furthest first.
+     */
+
+    moves = growScratch(gb)->gridbox.moves ;
+    for (childP = children, rect = rects, move = moves;
+	 childP - children < num_children; childP++)
+      if( XtIsManaged(*childP) )
+      {
+	if( rect->x != (*childP)->core.x || rect->y != (*childP)->core.y ||
+	    rect->width != (*childP)->core.width ||
+	    rect->height != (*childP)->core.height )
+	{
+	  move->child = *childP ;
+	  move->rect = rect ;
+	  move->key = rect->x + rect->y ;
+	  n = move->key - ((*childP)->core.x + (*childP)->core.y) ;
+	  move->group = n > 0  ||  (n == 0  &&
+		rect->width + rect->height >
+		(*childP)->core.width + (*childP)->core.height) ;
+	  if( move->group )
+	    move->key = -move->key ;
+	  ++move ;
+	}
+	++rect ;
+      }
+    n = move - moves ;
+    if( n > 1 )
+      qsort(moves, n, sizeof(GridboxMove), moveCompare) ;
+
+    /* With batchConfigure, take the children which change off the
+     * screen while they move, so that each is drawn once, in its new
+     * place.  The Gridbox itself stays mapped; only the area the
+     * children leave is exposed in it.
+     */
+    batch = gb->gridbox.batchConfigure && n > 1 && XtIsRealized((Widget)gb) ;
+    if( batch )
+      for(move = moves; move < moves+n; ++move)
+	if( isMapped(move->child) )
+	  XUnmapWindow(XtDisplay(move->child), XtWindow(move->child)) ;
+
+    for(move = moves; move < moves+n; ++move)
+    {
+      gc = (GridboxConstraints) move->child->core.constraints ;
+      if( gb->gridbox.preserveContents && !gc->gridbox.bit_gravity &&
+	  XtIsWidget(move->child) && XtIsRealized(move->child) )
+      {
+	attr.bit_gravity = NorthWestGravity ;
+	XChangeWindowAttributes(XtDisplay(move->child),
+	  XtWindow(move->child), CWBitGravity, &attr) ;
+	gc->gridbox.bit_gravity = True ;
+      }
+      rect = move->rect ;
+      XtConfigureWidget(move->child, rect->x, rect->y,
+	rect->width, rect->height, move->child->core.border_width );
+    }
+
+    if( batch )
+      for(move = moves; move < moves+n; ++move)
+	if( isMapped(move->child) )
+	  XMapWindow(XtDisplay(move->child), XtWindow(move->child)) ;
+}
+
+
+	/* Is this child's window mapped?  Xt maps a realized, managed
+	 * widget unless mappedWhenManaged is off.
+	 */
+
+static	Bool
+isMapped(w)
+    Widget	w ;
+{
+    return XtIsWidget(w) && XtIsRealized(w) && w->core.mapped_when_managed ;
+}
+
+
+static	int
+moveCompare(a, b)
+    const void	*a, *b ;
+{
+    const GridboxMove	*ma = a, *mb = b ;
+
+    if( ma->group != mb->group )
+      return ma->group - mb->group ;
+    return ma->key - mb->key ;
+}
+
+
+	/* Make sure the scratch buffers used by applyRects() and
+	 * linearLayout() have room for every child.
+	 */
+
+static	GridboxWidget
+growScratch(gb)
+    GridboxWidget	gb ;
+{
+    int		n = gb->composite.num_children ;
+
+    if( gb->gridbox.scratch_alloc < n ) {
+      n += n/2 ;
+      gb->gridbox.scratch_rects = (GridboxRect *)
+	XtRealloc((char *)gb->gridbox.scratch_rects, n * sizeof(GridboxRect));
+      gb->gridbox.moves = (GridboxMove *)
+	XtRealloc((char *)gb->gridbox.moves, n * sizeof(GridboxMove)) ;
+      gb->gridbox.scratch_alloc = n ;
+    }
+    return gb ;
+}
+
+
+	/* Count exposures of the Gridbox and its children, to measure
+	 * how well applyRects() avoids them.
+	 */
+
+/* ARGSUSED */
+static	void
+countExpose(w, client_data, event, cont)
+    Widget	w ;
+    XtPointer	client_data ;
+    XEvent	*event ;
+    Boolean	*cont ;
+{
+    if( event->type == Expose || event->type == GraphicsExpose )
+      ++((GridboxWidget)client_data)->gridbox.stats.exposes ;
+}
+
+
+	/* preserveContents has been turned off; give the children back
+	 * the default bit gravity.
+	 */
+
+static	void
+forgetContents(gb)
+    GridboxWidget	gb ;
+{
+    WidgetList	children = gb->composite.children;
+    int		num_children = gb->composite.num_children;
+    Widget	*childP;
+    GridboxConstraints	gc ;
+    XSetWindowAttributes attr ;
+
+    attr.bit_gravity = ForgetGravity ;
+    for (childP = children; childP - children < num_children; childP++)
+    {
+      gc = (GridboxConstraints) (*childP)->core.constraints ;
+      if( gc->gridbox.bit_gravity && XtIsRealized(*childP) )
+	XChangeWindowAttributes(XtDisplay(*childP), XtWindow(*childP),
+	  CWBitGravity, &attr) ;
+      gc->gridbox.bit_gravity = False ;
+    }
+}
+
+
+	/* Record the geometry of every child before a layout, so that
+	 * reportLayout() can tell which ones it changed.
+	 */
+
+static	GridboxRect *
+saveGeometry(gb)
+    GridboxWidget	gb ;
+{
+    WidgetList	children = gb->composite.children;
+    int		num_children = gb->composite.num_children;
+    GridboxRect	*rects, *rect ;
+    int		i ;
+
+    rects = XTCALLOC(max(num_children,1), GridboxRect) ;
+    for(i=0, rect=rects; i < num_children; ++i, ++rect) {
+      rect->x = children[i]->core.x ;
+      rect->y = children[i]->core.y ;
+      rect->width = children[i]->core.width ;
+      rect->height = children[i]->core.height ;
+    }
+    return rects ;
+}
+
+
+	/* Compare the children's geometry with that saved by
+	 * saveGeometry() and, if any have been moved or resized,
+	 * call the layoutCallback with the list.  Frees 'old'.
+	 */
+
+static	void
+reportLayout(gb, old)
+    GridboxWidget	gb ;
+    GridboxRect		*old ;
+{
+    WidgetList	children = gb->composite.children;
+    int		num_children = gb->composite.num_children;
+    Widget	child ;
+    GridboxChange	*changes, *change ;
+    GridboxLayoutCallbackStruct	cbs ;
+    GridboxConstraints	gc ;
+    int		i ;
+
+    changes = XTCALLOC(max(num_children,1), GridboxChange) ;
+    cbs.first_column = cbs.first_row = INT_MAX ;
+    cbs.last_column = cbs.last_row = -1 ;
+
+    for(i=0, change=changes; i < num_children; ++i)
+    {
+      child = children[i] ;
+      if( !XtIsManaged(child) ||
+	  (child->core.x == old[i].x && child->core.y == old[i].y &&
+	   child->core.width == old[i].width &&
+	   child->core.height == old[i].height) )
+	continue ;
+
+      change->child = child ;
+      change->old_geometry.x = old[i].x ;
+      change->old_geometry.y = old[i].y ;
+      change->old_geometry.width = old[i].width ;
+      change->old_geometry.height = old[i].height ;
+      change->new_geometry.x = child->core.x ;
+      change->new_geometry.y = child->core.y ;
+      change->new_geometry.width = child->core.width ;
+      change->new_geometry.height = child->core.height ;
+      ++change ;
+
+      gc = (GridboxConstraints) child->core.constraints ;
+      cbs.first_column = min(cbs.first_column, gc->gridbox.gridx) ;
+      cbs.last_column = max(cbs.last_column,
+		gc->gridbox.gridx + gc->gridbox.gridWidth - 1) ;
+      cbs.first_row = min(cbs.first_row, gc->gridbox.gridy) ;
+      cbs.last_row = max(cbs.last_row,
+		gc->gridbox.gridy + gc->gridbox.gridHeight - 1) ;
+    }
+
+    cbs.changes = changes ;
+    cbs.nchanges = change - changes ;
+    if( cbs.nchanges > 0 )
+      XtCallCallbacks((Widget)gb, XtNlayoutCallback, (XtPointer)&cbs) ;
+
+    XtFree((char *)changes) ;
+    XtFree((char *)old) ;
+}
+
+
 /* ARGSUSED */
 static	Boolean
 GridboxSetValues(current, request, new, args, num_args)
@@ -459,11 +1167,88 @@ GridboxSetValues(current, request, new, args, num_args)
     ArgList args;
     Cardinal *num_args;
 {
-    /* The only resource is the default margin.	 I don't
-     * think there's any reason to react to changes therein, so
-     * this function does nothing.
+    GridboxWidget gbCur = (GridboxWidget)current ;
+    GridboxWidget gbNew = (GridboxWidget)new ;
+    Boolean	  tracks = False ;
+
+    /* I don't think there's any reason to react to changes in
+     * the default margin.  Changing homogeneous or the row & column
+     * declarations changes all row & column sizes.
      */
 
+    if( gbCur->gridbox.columnSpec != gbNew->gridbox.columnSpec )
+    {
+      XtFree(gbCur->gridbox.columnSpec) ;
+      if( gbNew->gridbox.columnSpec != NULL )
+	gbNew->gridbox.columnSpec = XtNewString(gbNew->gridbox.columnSpec) ;
+      parseTrackSpec(gbNew->gridbox.columnSpec,
+	  &gbNew->gridbox.col_tracks, &gbNew->gridbox.ncol_tracks) ;
+      tracks = True ;
+    }
+
+    if( gbCur->gridbox.rowSpec != gbNew->gridbox.rowSpec )
+    {
+      XtFree(gbCur->gridbox.rowSpec) ;
+      if( gbNew->gridbox.rowSpec != NULL )
+	gbNew->gridbox.rowSpec = XtNewString(gbNew->gridbox.rowSpec) ;
+      parseTrackSpec(gbNew->gridbox.rowSpec,
+	  &gbNew->gridbox.row_tracks, &gbNew->gridbox.nrow_tracks) ;
+      tracks = True ;
+    }
+
+    if( gbCur->gridbox.layoutCacheFile != gbNew->gridbox.layoutCacheFile )
+    {
+      XtFree(gbCur->gridbox.layoutCacheFile) ;
+      if( gbNew->gridbox.layoutCacheFile != NULL )
+	gbNew->gridbox.layoutCacheFile =
+	    XtNewString(gbNew->gridbox.layoutCacheFile) ;
+    }
+
+    /* traceFile can only be set at creation */
+    if( gbCur->gridbox.traceFile != gbNew->gridbox.traceFile )
+    {
+      XtAppWarning(XtWidgetToApplicationContext(new),
+	  "Gridbox: traceFile cannot be changed") ;
+      gbNew->gridbox.traceFile = gbCur->gridbox.traceFile ;
+    }
+
+    if( gbCur->gridbox.defaultDistance != gbNew->gridbox.defaultDistance )
+      ++gbNew->gridbox.generation ;
+
+    if( gbCur->gridbox.publishLayout != gbNew->gridbox.publishLayout )
+      publishLayout(gbNew, gbNew->gridbox.publishLayout) ;
+
+    if( gbCur->gridbox.preserveContents && !gbNew->gridbox.preserveContents )
+      forgetContents(gbNew) ;
+
+    /* Fixed tracks affect which children are queried */
+    if( tracks && gbNew->gridbox.max_wids != NULL )
+      getPreferredSizes(gbNew, True) ;
+
+    /* A homogeneous Gridbox takes no part in its size groups */
+    if( gbNew->gridbox.homogeneous && !gbCur->gridbox.homogeneous ) {
+      if( gbNew->gridbox.colgroup != NULL )
+	groupContribute(gbNew->gridbox.colgroup, gbNew, True, NULL, 0) ;
+      if( gbNew->gridbox.rowgroup != NULL )
+	groupContribute(gbNew->gridbox.rowgroup, gbNew, False, NULL, 0) ;
+    }
+
+    /* Ask for our new preferred size, unless given another */
+    if( tracks || gbCur->gridbox.homogeneous != gbNew->gridbox.homogeneous )
+    {
+      if( gbNew->gridbox.max_wids != NULL )
+      {
+	computeWidHgtMax(gbNew) ;
+	if( request->core.width == current->core.width )
+	  new->core.width = ToDimension(gbNew->gridbox.total_wid) ;
+	if( request->core.height == current->core.height )
+	  new->core.height = ToDimension(gbNew->gridbox.total_hgt) ;
+      }
+      gbNew->gridbox.needs_layout = True ;
+      ++gbNew->gridbox.generation ;
+      return( TRUE );
+    }
+
     return( FALSE );
 }
 
@@ -476,7 +1261,29 @@ static	void
 GridboxDestroy(w)
 	Widget	w ;
 {
-	freeAll( (GridboxWidget)w ) ;
+	GridboxWidget gb = (GridboxWidget)w ;
+
+	groupJoin(gb, True, NULL) ;
+	groupJoin(gb, False, NULL) ;
+	freeAll(gb) ;
+	cacheFree(gb) ;
+	XtFree((char *)gb->gridbox.col_tracks) ;
+	XtFree((char *)gb->gridbox.row_tracks) ;
+	XtFree(gb->gridbox.columnSpec) ;
+	XtFree(gb->gridbox.rowSpec) ;
+	XtFree(gb->gridbox.layoutCacheFile) ;
+	XtFree(gb->gridbox.traceFile) ;
+	if( gb->gridbox.saved_proc != (XtWorkProcId)0 )
+	  XtRemoveWorkProc(gb->gridbox.saved_proc) ;
+	if( gb->gridbox.trace != NULL )
+	  traceClose(gb) ;
+	publishLayout(gb, False) ;
+	reapLayouts(gb, True) ;
+	if( gb->gridbox.reap_proc != (XtWorkProcId)0 )
+	  XtRemoveWorkProc(gb->gridbox.reap_proc) ;
+	XtFree((char *)gb->gridbox.scratch_rects) ;
+	XtFree((char *)gb->gridbox.moves) ;
+	XtFree((char *)gb->gridbox.gadgets) ;
 }
 
 
@@ -487,21 +1294,75 @@ static	XtGeometryResult
 GridboxQueryGeometry( widget, request, reply  )
     Widget widget;
     XtWidgetGeometry *request, *reply;
+{
+    GridboxWidget	gb = (GridboxWidget)widget;
+    XtGeometryResult	result ;
+    unsigned long	t0 ;
+    int			args[7] ;
+
+    PROBE4(query_start, gb, request->request_mode,
+	request->width, request->height) ;
+
+    if( gb->gridbox.trace == NULL ) {
+      result = queryGeometry(widget, request, reply) ;
+      PROBE4(query_done, gb, result, reply->width, reply->height) ;
+      return result ;
+    }
+
+    t0 = traceTime(gb) ;
+    ++traceDepth ;
+    result = queryGeometry(widget, request, reply) ;
+    --traceDepth ;
+    PROBE4(query_done, gb, result, reply->width, reply->height) ;
+    args[0] = request->request_mode ;
+    args[1] = request->width ;
+    args[2] = request->height ;
+    args[3] = result ;
+    args[4] = reply->width ;
+    args[5] = reply->height ;
+    args[6] = traceTime(gb) - t0 ;
+    traceRecord(gb, GBT_QUERY, NULL, args, 7) ;
+    return result ;
+}
+
+
+static	XtGeometryResult
+queryGeometry( widget, request, reply  )
+    Widget widget;
+    XtWidgetGeometry *request, *reply;
 {
     GridboxWidget gb = (GridboxWidget)widget;
 
     /* determine how much space the rows & columns need */
 
-    if( gb->gridbox.max_wids == NULL ) {
-      getPreferredSizes(gb) ;
+    if( gb->gridbox.max_wids == NULL || gb->gridbox.dormant_dirty ) {
+      getPreferredSizes(gb, False) ;
       computeWidHgtInfo(gb) ;
+      gb->gridbox.dormant_dirty = False ;
     }
 
     reply->request_mode = CWWidth | CWHeight;
-    reply->width = gb->gridbox.total_wid;
-    reply->height = gb->gridbox.total_hgt;
+    reply->width = ToDimension(gb->gridbox.total_wid) ;
+    reply->height = ToDimension(gb->gridbox.total_hgt) ;
+
+    /* If the parent fixes one dimension, tell it how much we need
+     * in the other.  Otherwise we offer our preferred size as a
+     * compromise.
+     */
+
+    switch( request->request_mode & (CWWidth|CWHeight) ) {
+      case CWWidth:
+	reply->width = request->width ;
+	reply->height = ToDimension(constrainedSize(gb, True, request->width)) ;
+	break ;
+      case CWHeight:
+	reply->height = request->height ;
+	reply->width = ToDimension(constrainedSize(gb, False, request->height)) ;
+	break ;
+    }
 
-    /* We always offer our preferred size as a compromise.  */
+    if( reply->width == gb->core.width && reply->height == gb->core.height )
+      return XtGeometryNo;
 
     if( (request->request_mode & CWWidth) &&
 		request->width == gb->core.width  &&
@@ -513,37 +1374,248 @@ GridboxQueryGeometry( widget, request, reply  )
 }
 
 
+	/* Work out how much room the grid needs in one dimension when
+	 * it is given 'size' in the other:  the height needed at a given
+	 * width if 'columns' is set, else the width needed at a given
+	 * height.  The size is shared out among the tracks as layout()
+	 * would do it, and children which are free to resize are queried
+	 * again at the size of their cells, so that children which wrap
+	 * report what they need at that size.  The widget itself is not
+	 * changed.
+	 */
 
-
+static	int
+constrainedSize(gb, columns, size)
+    GridboxWidget	gb ;
+    Bool		columns ;
+    int			size ;
+{
+    int		n = columns ? gb->gridbox.nx : gb->gridbox.ny ;
+    int		no = columns ? gb->gridbox.ny : gb->gridbox.nx ;
+    GridboxTrack *tracks = columns ? gb->gridbox.col_tracks : gb->gridbox.row_tracks ;
+    int		ntracks = columns ? gb->gridbox.ncol_tracks : gb->gridbox.nrow_tracks ;
+    GridboxTrack *otracks = columns ? gb->gridbox.row_tracks : gb->gridbox.col_tracks ;
+    int		notracks = columns ? gb->gridbox.nrow_tracks : gb->gridbox.ncol_tracks ;
+    GridboxGroup group = columns ? gb->gridbox.rowgroup : gb->gridbox.colgroup ;
+    int		maxspan = columns ? gb->gridbox.maxgh : gb->gridbox.maxgw ;
+    int		mincellsize = gb->gridbox.defaultDistance * 2 + 1 ;
+    int		*sizes, *osizes, *prefs ;
+    int		*oweights ;
+    int		i, j, cell, spare, total, margin ;
+    int		pos, span, pref, opos, ospan ;
+    Widget	*childP ;
+    GridboxConstraints	gc ;
+    XtWidgetGeometry	intended, preferred ;
 
-	/* COMPOSITE WIDGET FUNCTIONS */
+    if( n <= 0 || no <= 0 )
+      return columns ? gb->gridbox.total_hgt : gb->gridbox.total_wid ;
 
+    sizes = XTCALLOC(n, int) ;
+    osizes = XTCALLOC(no, int) ;
+    oweights = XTCALLOC(no, int) ;
+    prefs = XTCALLOC(gb->composite.num_children, int) ;
 
-static	void
-GridboxChangeManaged(w)
-    Widget w;
-{
-    GridboxWidget gb = (GridboxWidget)w;
-    XtWidgetGeometry reply;
-    int		width, height ;
+    /* share the given size out among the tracks */
 
-    getPreferredSizes(gb) ;
-    computeWidHgtInfo(gb) ;
-    width = gb->gridbox.total_wid ;
-    height = gb->gridbox.total_hgt ;
+    if( gb->gridbox.uniform )
+    {
+      uniformAxis(n, columns ? gb->gridbox.uniform_wid : gb->gridbox.uniform_hgt,
+	size - (columns ? gb->gridbox.total_wid : gb->gridbox.total_hgt),
+	columns ? gb->gridbox.total_weightx : gb->gridbox.total_weighty,
+	mincellsize, &cell, &spare) ;
+      for(i=0; i < n; ++i)
+	sizes[i] = cell + (i+1)*spare/n - i*spare/n ;
+    }
+    else if( columns )
+      layoutAxis(n, gb->gridbox.max_wids, gb->gridbox.max_weightx,
+	size - gb->gridbox.total_wid, gb->gridbox.total_weightx, mincellsize,
+	tracks, ntracks, sizes) ;
+    else
+      layoutAxis(n, gb->gridbox.max_hgts, gb->gridbox.max_weighty,
+	size - gb->gridbox.total_hgt, gb->gridbox.total_weighty, mincellsize,
+	tracks, ntracks, sizes) ;
 
-    /* ask to change geometry to accomodate; accept any compromise offered */
-    if( changeGeometry(gb, width, height, False, &reply) == XtGeometryAlmost )
-      (void) changeGeometry(gb, reply.width, reply.height, False, &reply) ;
+    /* find out what each child needs in the other dimension at
+     * the size of its cell.
+     */
 
-    /* always re-execute layout */
-    XtClass(w)->core_class.resize((Widget)gb) ;
+    for( i=0, childP = gb->composite.children;
+	 i < gb->composite.num_children ;
+	 ++i, ++childP )
+      if( XtIsManaged(*childP) )
+      {
+	gc = (GridboxConstraints) (*childP)->core.constraints ;
+	pos = columns ? gc->gridbox.gridx : gc->gridbox.gridy ;
+	span = columns ? gc->gridbox.gridWidth : gc->gridbox.gridHeight ;
+	pref = columns ? gc->gridbox.prefWidth : gc->gridbox.prefHeight ;
+	opos = columns ? gc->gridbox.gridy : gc->gridbox.gridx ;
+	ospan = columns ? gc->gridbox.gridHeight : gc->gridbox.gridWidth ;
+	prefs[i] = columns ? gc->gridbox.prefHeight : gc->gridbox.prefWidth ;
+
+	for(cell=0, j=0; j < span && pos+j < n; ++j)
+	  cell += sizes[pos+j] ;
+
+	if( !gc->gridbox.allowResize  ||  cell == pref  ||
+	    fixedSize(tracks, ntracks, pos, span) > 0  ||
+	    fixedSize(otracks, notracks, opos, ospan) > 0 )
+	  continue ;
+
+	margin = (gc->gridbox.margin + (*childP)->core.border_width) * 2 ;
+	intended.request_mode = columns ? CWWidth : CWHeight ;
+	intended.width = intended.height = max(cell - margin, 1) ;
+	(void) XtQueryGeometry(*childP, &intended, &preferred) ;
+	margin = (gc->gridbox.margin + preferred.border_width) * 2 ;
+	prefs[i] = (columns ? preferred.height : preferred.width) + margin ;
+      }
+
+    /* and size the other tracks to fit, as computeWidHgtMax() or
+     * computeUniformMax() would.
+     */
+
+    if( gb->gridbox.homogeneous )
+    {
+      for( i=0, cell=0, childP = gb->composite.children;
+	   i < gb->composite.num_children ;
+	   ++i, ++childP )
+	if( XtIsManaged(*childP) )
+	{
+	  gc = (GridboxConstraints) (*childP)->core.constraints ;
+	  opos = columns ? gc->gridbox.gridy : gc->gridbox.gridx ;
+	  ospan = max(columns ? gc->gridbox.gridHeight : gc->gridbox.gridWidth, 1) ;
+	  if( fixedSize(otracks, notracks, opos, ospan) == 0 )
+	    cell = max(cell, (prefs[i] + ospan-1) / ospan) ;
+	}
+      for(i=0; i < no; ++i)
+	osizes[i] = cell ;
+      clampTracks(otracks, notracks, osizes, no) ;
+
+      for(i=0, total=0; i < no; ++i)
+	total += osizes[i] ;
+    }
+    else
+    {
+      for(j=1; j <= maxspan; ++j)
+	for( i=0, childP = gb->composite.children;
+	     i < gb->composite.num_children ;
+	     ++i, ++childP )
+	  if( XtIsManaged(*childP) )
+	  {
+	    gc = (GridboxConstraints) (*childP)->core.constraints ;
+	    opos = columns ? gc->gridbox.gridy : gc->gridbox.gridx ;
+	    ospan = columns ? gc->gridbox.gridHeight : gc->gridbox.gridWidth ;
+	    if( ospan == j  &&  fixedSize(otracks, notracks, opos, ospan) == 0 )
+	      computeWidHgtUtil(opos, ospan, prefs[i],
+		columns ? gc->gridbox.weighty : gc->gridbox.weightx,
+		osizes, oweights) ;
+	  }
+
+      if( group != NULL )
+	for(i=0; i < no && i < group->nsizes; ++i)
+	  osizes[i] = max(osizes[i], group->sizes[i]) ;
+      clampTracks(otracks, notracks, osizes, no) ;
+
+      for(i=0, total=0; i < no; ++i)
+	total += osizes[i] ;
+    }
+
+    XtFree((char *)sizes) ;
+    XtFree((char *)osizes) ;
+    XtFree((char *)oweights) ;
+    XtFree((char *)prefs) ;
+    return total ;
 }
 
 
 
+
 
-	/* Respond to size change requests from a child.
+	/* COMPOSITE WIDGET FUNCTIONS */
+
+
+static	void
+GridboxChangeManaged(w)
+    Widget w;
+{
+    GridboxWidget	gb = (GridboxWidget)w;
+    Widget		*childP ;
+    unsigned long	t0 ;
+    int			i ;
+    int			args[2] ;
+
+    if( gb->gridbox.trace == NULL ) {
+      changeManaged(w) ;
+      return ;
+    }
+
+    t0 = traceTime(gb) ;
+    ++traceDepth ;
+    changeManaged(w) ;
+    --traceDepth ;
+
+    args[0] = 0 ;
+    for( i=0, childP = gb->composite.children;
+	 i < gb->composite.num_children ;
+	 ++i, ++childP )
+      if( XtIsManaged(*childP) )
+	++args[0] ;
+    args[1] = traceTime(gb) - t0 ;
+    traceRecord(gb, GBT_MANAGED, NULL, args, 2) ;
+
+    for( i=0, childP = gb->composite.children;
+	 i < gb->composite.num_children ;
+	 ++i, ++childP )
+      if( XtIsManaged(*childP) )
+	traceChild(gb, GBT_CHILD, *childP) ;
+}
+
+
+static	void
+changeManaged(w)
+    Widget w;
+{
+    GridboxWidget gb = (GridboxWidget)w;
+
+    /* The first time through, try to get the preferred sizes from
+     * the layout cache file.  Either way, check them and update the
+     * file later, when the application is idle.
+     */
+    if( gb->gridbox.saved_state == SAVED_NONE &&
+	gb->gridbox.layoutCacheFile != NULL )
+    {
+      gb->gridbox.saved_hash = layoutHash(gb, &gb->gridbox.saved_nchild) ;
+      gb->gridbox.saved_loaded = loadPrefs(gb) ;
+      gb->gridbox.saved_state = SAVED_PENDING ;
+      gb->gridbox.saved_proc = XtAppAddWorkProc(XtWidgetToApplicationContext(w),
+	  validatePrefs, (XtPointer)gb) ;
+      if( gb->gridbox.saved_loaded && !dormant(gb) ) {
+	relayout(gb) ;
+	return ;
+      }
+    }
+
+    /* The preferred sizes loaded above are marked valid, so catchUp()
+     * won't query for them again.
+     */
+    if( dormant(gb) ) {
+      gb->gridbox.dormant_dirty = True ;
+      gb->gridbox.needs_layout = True ;
+      return ;
+    }
+
+    /* Only newly-managed children are queried.  If the children
+     * that came and went are simple enough, only the rows & columns
+     * they occupy are recomputed.
+     */
+    getPreferredSizes(gb, False) ;
+    if( gb->gridbox.max_wids == NULL || !updateTracks(gb, NULL) )
+      computeWidHgtInfo(gb) ;
+    fitToGrid(gb) ;
+}
+
+
+
+
+	/* Respond to size change requests from a child.
 	 *
 	 * Recompute row/column sizes based on child request
 	 * and request to change my own size accordingly.
@@ -568,18 +1640,81 @@ GridboxGeometryManager(w, request, reply)
     Widget w;
     XtWidgetGeometry *request;
     XtWidgetGeometry *reply;	/* RETURN */
+{
+    GridboxWidget	gb = (GridboxWidget) XtParent(w);
+    XtGeometryResult	result ;
+    unsigned long	t0 ;
+    int			args[6] ;
+
+    PROBE5(request_start, gb, w, request->request_mode,
+	request->width, request->height) ;
+
+    if( gb->gridbox.negotiating >= MAX_NEGOTIATION ) {
+      XtAppWarning(XtWidgetToApplicationContext(w),
+	  "Gridbox: geometry negotiation does not converge") ;
+      PROBE5(request_done, gb, w, XtGeometryNo,
+	  w->core.width, w->core.height) ;
+      return XtGeometryNo ;
+    }
+
+    ++gb->gridbox.negotiating ;
+    if( gb->gridbox.trace == NULL ) {
+      result = geometryManager(w, request, reply) ;
+      --gb->gridbox.negotiating ;
+      PROBE5(request_done, gb, w, result,
+	  result == XtGeometryAlmost ? reply->width : w->core.width,
+	  result == XtGeometryAlmost ? reply->height : w->core.height) ;
+      return result ;
+    }
+
+    args[0] = request->request_mode ;
+    args[1] = request->x ;
+    args[2] = request->y ;
+    args[3] = request->width ;
+    args[4] = request->height ;
+    args[5] = request->border_width ;
+    traceRecord(gb, GBT_REQUEST, w, args, 6) ;
+
+    t0 = traceTime(gb) ;
+    ++traceDepth ;
+    result = geometryManager(w, request, reply) ;
+    --traceDepth ;
+    --gb->gridbox.negotiating ;
+
+    args[0] = result ;
+    if( result == XtGeometryAlmost ) {
+      args[1] = reply->width ;
+      args[2] = reply->height ;
+      args[3] = reply->border_width ;
+    } else {
+      args[1] = w->core.width ;
+      args[2] = w->core.height ;
+      args[3] = w->core.border_width ;
+    }
+    args[4] = traceTime(gb) - t0 ;
+    traceRecord(gb, GBT_REPLY, w, args, 5) ;
+    PROBE5(request_done, gb, w, result, args[1], args[2]) ;
+    return result ;
+}
+
+
+static	XtGeometryResult
+geometryManager(w, request, reply)
+    Widget w;
+    XtWidgetGeometry *request;
+    XtWidgetGeometry *reply;	/* RETURN */
 {
     int			new_width, new_height ;
     int			old_width, old_height ;
     int			old_cw, old_ch ;
-    Dimension		cell_width, cell_height ;
+    int			cell_width, cell_height ;
     GridboxWidget	gb = (GridboxWidget) XtParent(w);
     GridboxConstraints	gc = (GridboxConstraints) w->core.constraints;
     XtWidgetGeometry	myreply ;
     XtGeometryResult	result ;
     int			queryOnly = request->request_mode & XtCWQueryOnly ;
     int			margin ;
-    Position		x,y ;
+    int			x,y ;
 
     /* Position requests always denied */
 
@@ -619,6 +1754,44 @@ GridboxGeometryManager(w, request, reply)
     gc->gridbox.prefWidth = request->width + margin ;
     gc->gridbox.prefHeight = request->height + margin ;
 
+    /* We're not on the screen; grant the request and sort it all out
+     * when we are again.  If we're merely obscured, the child's size
+     * still matters to whoever can see through to it (a window manager
+     * thumbnail, say), so the request is handled as usual.
+     */
+    if( gc->gridbox.allowResize && !queryOnly && withdrawn(gb) ) {
+      gb->gridbox.dormant_dirty = True ;
+      gb->gridbox.needs_layout = True ;
+      return XtGeometryYes ;
+    }
+
+    /* If the child still fits the rows & columns it's in without
+     * changing their sizes, nothing else moves; only the child need
+     * be reconfigured.
+     */
+    if( gc->gridbox.allowResize && !gb->gridbox.needs_layout &&
+	fitsTracks(gb, gc, old_cw, old_ch) )
+    {
+      cellOrigin(gb, gc, &x, &y) ;
+      layoutChild(gb, w, &cell_width, &cell_height, &x,&y) ;
+
+      if( queryOnly ) {
+	gc->gridbox.prefWidth = old_cw ;
+	gc->gridbox.prefHeight = old_ch ;
+      }
+
+      if( (cell_width == w->core.width && cell_height == w->core.height) ||
+	  cell_width != request->width || cell_height != request->height )
+	return refuseRequest(gb, gc, old_cw, old_ch, False) ;
+
+      if( queryOnly )
+	return XtGeometryYes ;
+
+      ++gb->gridbox.stats.fast_grants ;
+      moveChild(gb, w, x, y, cell_width, cell_height) ;
+      return XtGeometryDone ;
+    }
+
     if( gc->gridbox.allowResize )
     {
       /* recompute minimum row & column sizes */
@@ -665,7 +1838,7 @@ GridboxGeometryManager(w, request, reply)
 
       /* can't change */
       if( cell_width == w->core.width && cell_height == w->core.height )
-	return XtGeometryNo ;
+	return refuseRequest(gb, gc, old_cw, old_ch, True) ;
 
       /* request granted */
       if( cell_width == request->width && cell_height == request->height )
@@ -698,13 +1871,17 @@ GridboxGeometryManager(w, request, reply)
 	  cell_height >= gc->gridbox.prefHeight )
       {
 	if( !queryOnly ) {
-	  (void) changeGeometry(gb, myreply.width, myreply.height, False, NULL);
+	  /* Our size stays the same, but layouts made with the old
+	   * preferred size no longer apply.
+	   */
+	  ++gb->gridbox.generation ;
 	  XtClass((Widget)gb)->core_class.resize((Widget)gb) ;
 	  return XtGeometryDone ;
 	}
 	else
 	  return XtGeometryYes ;
       }
+      return refuseRequest(gb, gc, old_cw, old_ch, False) ;
     }
 
     /* TODO: this needs to be re-worked.  If we offer a compromise,
@@ -719,14 +1896,62 @@ GridboxGeometryManager(w, request, reply)
     reply->request_mode = CWWidth | CWHeight ;
     return XtGeometryAlmost ;
 #endif	/* COMMENT */
+    return refuseRequest(gb, gc, old_cw, old_ch, True) ;
+}
+
+
+	/* Refuse a child's request:  put back its preferred size, and,
+	 * with recompute, the row & column sizes computed from the size
+	 * it asked for.  A query has already put everything back.
+	 */
+
+static	XtGeometryResult
+refuseRequest(gb, gc, old_cw, old_ch, recompute)
+    GridboxWidget	gb ;
+    GridboxConstraints	gc ;
+    int			old_cw, old_ch ;
+    Bool		recompute ;
+{
+    if( gc->gridbox.prefWidth != old_cw || gc->gridbox.prefHeight != old_ch )
+    {
+      gc->gridbox.prefWidth = old_cw ;
+      gc->gridbox.prefHeight = old_ch ;
+      if( recompute ) {
+	computeWidHgtMax(gb) ;
+	layout(gb, gb->core.width, gb->core.height) ;
+      }
+    }
     return XtGeometryNo ;
 }
 
 
 
-/* No delete_child function.  It might make sense to resize the
- * grid again, but for now we'll just leave it alone.
- */
+	/* Normally a child is unmanaged before it's deleted, and
+	 * change_managed has already taken it out of the grid.  But
+	 * Xt doesn't call change_managed while we're unrealized, so
+	 * do it here.  Layout happens when we're realized.
+	 */
+
+static	void
+GridboxDeleteChild(w)
+    Widget w;
+{
+    GridboxWidget gb = (GridboxWidget)XtParent(w) ;
+    GridboxConstraints gc = (GridboxConstraints) w->core.constraints ;
+
+    if( gc->gridbox.counted && !gb->core.being_destroyed &&
+	gb->gridbox.max_wids != NULL )
+    {
+      if( !updateTracks(gb, NULL) )
+	computeWidHgtInfo(gb) ;
+      gb->gridbox.needs_layout = True ;
+    }
+
+    if( gc->gridbox.hidden )
+      --gb->gridbox.nhidden ;
+
+    (*((CompositeWidgetClass)SuperClass)->composite_class.delete_child)(w) ;
+}
 
 
 
@@ -747,6 +1972,14 @@ GridboxConstraintInit(request, new, args, num_args)
     if( gc->gridbox.margin < 0 )
 	gc->gridbox.margin = gb->gridbox.defaultDistance;
 
+    gc->gridbox.prefs_valid = False ;
+    gc->gridbox.counted = False ;
+    gc->gridbox.hidden = False ;
+    gc->gridbox.bit_gravity = False ;
+
+    if( XtIsWidget(new) )
+      XtAddEventHandler(new, ExposureMask, False, countExpose, (XtPointer)gb);
+
     /* TODO: how about resources that cause a child to use all
      * remaining space, or to start a new row?
      */
@@ -767,24 +2000,81 @@ GridboxConstraintSetValues(current, request, new, args, num_args)
   GridboxConstraints gcCur = (GridboxConstraints) current->core.constraints;
   GridboxConstraints gcNew = (GridboxConstraints) new->core.constraints;
   GridboxWidget gb = (GridboxWidget) XtParent(new) ;
-
+  GridboxConstraintsPart saved ;
+  Bool		ok ;
+  Bool		tracing = gb->gridbox.trace != NULL ;
+
+  if( tracing )
+    ++traceDepth ;
+
+  /* Changes to position, size, weight or margin change the child's
+   * contribution to its rows & columns.  Take the child out of the
+   * grid with its old constraints and put it back with the new ones.
+   * No other child is queried.
+   */
   if (gcCur->gridbox.gridx	!= gcNew->gridbox.gridx		||
       gcCur->gridbox.gridy	!= gcNew->gridbox.gridy		||
       gcCur->gridbox.gridWidth	!= gcNew->gridbox.gridWidth	||
-      gcCur->gridbox.gridHeight != gcNew->gridbox.gridHeight )
+      gcCur->gridbox.gridHeight != gcNew->gridbox.gridHeight	||
+      gcCur->gridbox.weightx	!= gcNew->gridbox.weightx	||
+      gcCur->gridbox.weighty	!= gcNew->gridbox.weighty	||
+      gcCur->gridbox.margin	!= gcNew->gridbox.margin	||
+      gcCur->gridbox.allowResize != gcNew->gridbox.allowResize )
   {
-      freeAll(gb) ;
-      getPreferredSizes(gb) ;
-      gb->gridbox.needs_layout = True ;
+    /* preferred sizes include the margin */
+    if( gcNew->gridbox.margin != gcCur->gridbox.margin ) {
+      gcNew->gridbox.prefWidth = max(0, gcNew->gridbox.prefWidth +
+	  2*(gcNew->gridbox.margin - gcCur->gridbox.margin)) ;
+      gcNew->gridbox.prefHeight = max(0, gcNew->gridbox.prefHeight +
+	  2*(gcNew->gridbox.margin - gcCur->gridbox.margin)) ;
+    }
+
+    /* Children in declared rows & columns may need to be queried
+     * differently in their new position.
+     */
+    if( gcCur->gridbox.allowResize != gcNew->gridbox.allowResize ||
+	gb->gridbox.ncol_tracks > 0 || gb->gridbox.nrow_tracks > 0 )
+      gcNew->gridbox.prefs_valid = False ;
+
+    if( XtIsManaged(new) && gb->gridbox.max_wids != NULL )
+    {
+      ok = False ;
+      if( gcNew->gridbox.counted )
+      {
+	saved = gcNew->gridbox ;
+	gcNew->gridbox = gcCur->gridbox ;
+	ok = updateTracks(gb, new) ;
+	saved.counted = gcNew->gridbox.counted ;
+	gcNew->gridbox = saved ;
+      }
+      getPreferredSizes(gb, False) ;
+      if( !ok || !updateTracks(gb, NULL) )
+	computeWidHgtInfo(gb) ;
+
+      if( XtIsRealized((Widget)gb) )
+	fitToGrid(gb) ;
+      else
+	gb->gridbox.needs_layout = True ;
+    }
   }
 
   else if( gcCur->gridbox.fill		!= gcNew->gridbox.fill		||
-	   gcCur->gridbox.gravity	!= gcNew->gridbox.gravity	||
-	   gcCur->gridbox.gravity	!= gcNew->gridbox.gravity	||
-	   gcCur->gridbox.gravity	!= gcNew->gridbox.gravity	||
 	   gcCur->gridbox.gravity	!= gcNew->gridbox.gravity )
   {
-      gb->gridbox.needs_layout = True ;
+    /* only this child's placement within its cell changes */
+    if( XtIsManaged(new) )
+    {
+      ++gb->gridbox.generation ;
+      if( XtIsRealized((Widget)gb) && gb->gridbox.max_wids != NULL )
+	XtClass((Widget)gb)->core_class.resize((Widget)gb) ;
+      else
+	gb->gridbox.needs_layout = True ;
+    }
+  }
+
+  if( tracing ) {
+    --traceDepth ;
+    traceChild(gb, GBT_CONSTRAINT, new) ;
   }
 
   return False ;		/* what does this signify? */
@@ -798,20 +2088,28 @@ GridboxConstraintSetValues(current, request, new, args, num_args)
 
 
 
-	/* Query all children, find out how much space they want.
+	/* Query children, find out how much space they want.
 	 * Add some for border & margin.
 	 * Call this whenever the set of managed children changes.
+	 * Unless 'all' is set, only children which haven't been
+	 * queried since they were managed are queried.
 	 */
 
 static	void
-getPreferredSizes(gb)
+getPreferredSizes(gb, all)
 	GridboxWidget	gb ;
+	Bool		all ;
 {
 	int	i ;
 	Widget	*childP ;
 	int	margin ;
+	int	fw, fh ;
 	GridboxConstraints gc, prevc=NULL ;
-	XtWidgetGeometry	preferred ;
+	XtWidgetGeometry	intended, preferred ;
+
+	PROBE3(prefs_start, gb, gb->composite.num_children, all) ;
+
+	++gb->gridbox.generation ;
 
 	for( i=0, childP = gb->composite.children;
 	     i < gb->composite.num_children ;
@@ -820,17 +2118,6 @@ getPreferredSizes(gb)
 	  {
 	    gc = (GridboxConstraints) (*childP)->core.constraints ;
 
-	    if( gc->gridbox.allowResize )
-	      (void) XtQueryGeometry(*childP, NULL, &preferred) ;
-	    else {
-	      preferred.width = (*childP)->core.width ;
-	      preferred.height = (*childP)->core.height ;
-	      preferred.border_width = (*childP)->core.border_width ;
-	    }
-	    margin = (gc->gridbox.margin + preferred.border_width) * 2 ;
-	    gc->gridbox.prefWidth = preferred.width + margin ;
-	    gc->gridbox.prefHeight = preferred.height + margin ;
-
 	    if( gc->gridbox.gridx == GRIDBOX_NEXT )
 	      gc->gridbox.gridx = prevc == NULL ? 0 :
 		      prevc->gridbox.gridx + prevc->gridbox.gridWidth ;
@@ -846,7 +2133,50 @@ getPreferredSizes(gb)
 	      gc->gridbox.gridy = prevc == NULL ? 0 : prevc->gridbox.gridy ;
 
 	    prevc = gc ;
+
+	    if( gc->gridbox.prefs_valid && !all )
+	      continue ;
+	    gc->gridbox.prefs_valid = True ;
+
+	    /* Children in fixed-size rows or columns don't get a say in
+	     * that dimension.  If both are fixed, don't query at all.
+	     */
+	    fw = fixedSize(gb->gridbox.col_tracks, gb->gridbox.ncol_tracks,
+		    gc->gridbox.gridx, gc->gridbox.gridWidth) ;
+	    fh = fixedSize(gb->gridbox.row_tracks, gb->gridbox.nrow_tracks,
+		    gc->gridbox.gridy, gc->gridbox.gridHeight) ;
+	    margin = (gc->gridbox.margin + (*childP)->core.border_width) * 2 ;
+
+	    if( !gc->gridbox.allowResize || (fw > 0 && fh > 0) ) {
+	      preferred.width = (*childP)->core.width ;
+	      preferred.height = (*childP)->core.height ;
+	      preferred.border_width = (*childP)->core.border_width ;
+	    }
+	    else if( fw > 0 || fh > 0 ) {
+	      intended.request_mode = 0 ;
+	      if( fw > 0 ) {
+		intended.request_mode |= CWWidth ;
+		intended.width = max(fw - margin, 1) ;
+	      }
+	      if( fh > 0 ) {
+		intended.request_mode |= CWHeight ;
+		intended.height = max(fh - margin, 1) ;
+	      }
+	      (void) XtQueryGeometry(*childP, &intended, &preferred) ;
+	    }
+	    else
+	      (void) XtQueryGeometry(*childP, NULL, &preferred) ;
+
+	    margin = (gc->gridbox.margin + preferred.border_width) * 2 ;
+	    gc->gridbox.prefWidth = preferred.width + margin ;
+	    gc->gridbox.prefHeight = preferred.height + margin ;
+	    if( fw > 0 && gc->gridbox.prefWidth > fw )
+	      gc->gridbox.prefWidth = fw ;
+	    if( fh > 0 && gc->gridbox.prefHeight > fh )
+	      gc->gridbox.prefHeight = fh ;
 	  }
+
+	PROBE3(prefs_done, gb, gb->composite.num_children, all) ;
 }
 
 
@@ -858,12 +2188,23 @@ static	void
 computeCellSize(gb, gc, rwid,rhgt)
 	GridboxWidget	gb ;
 	GridboxConstraints gc ;
-	Dimension	*rwid, *rhgt ;
+	int		*rwid, *rhgt ;
 {
-	Position	x,y ;
-	Dimension	wid,hgt ;
+	int		x,y ;
+	int		wid,hgt ;
 	int		i ;
-	Dimension	*wids, *hgts ;
+	int		*wids, *hgts ;
+
+	if( gb->gridbox.tracks_stale )
+	  layout(gb, gb->core.width, gb->core.height) ;
+
+	if( gb->gridbox.uniform ) {
+	  x = gc->gridbox.gridx ;
+	  y = gc->gridbox.gridy ;
+	  *rwid = ColumnEdge(gb, x + gc->gridbox.gridWidth) - ColumnEdge(gb, x);
+	  *rhgt = RowEdge(gb, y + gc->gridbox.gridHeight) - RowEdge(gb, y) ;
+	  return ;
+	}
 
 	wids = gb->gridbox.wids ;
 	hgts = gb->gridbox.hgts ;
@@ -881,16 +2222,54 @@ computeCellSize(gb, gc, rwid,rhgt)
 
 
 
+	/* Make the grid nc by nr.  The arrays are only reallocated
+	 * if they're too small.  New rows & columns are cleared.
+	 */
+
+#define	XTREALLOC(p,n,type)	((type *) XtRealloc((char *)(p), \
+				    (n) * sizeof(type)))
+
 static	void
-allocAll(gb)
+allocAll(gb, nc, nr)
     GridboxWidget	gb ;
+    int			nc, nr ;
 {
-    gb->gridbox.max_wids	= XTCALLOC(gb->gridbox.nx, Dimension) ;
-    gb->gridbox.max_hgts	= XTCALLOC(gb->gridbox.ny, Dimension) ;
-    gb->gridbox.wids		= XTCALLOC(gb->gridbox.nx, Dimension) ;
-    gb->gridbox.hgts		= XTCALLOC(gb->gridbox.ny, Dimension) ;
-    gb->gridbox.max_weightx	= XTCALLOC(gb->gridbox.nx, int) ;
-    gb->gridbox.max_weighty	= XTCALLOC(gb->gridbox.ny, int) ;
+    int		n ;
+
+    if( nc > gb->gridbox.nx_alloc || gb->gridbox.max_wids == NULL )
+    {
+      n = max(nc, gb->gridbox.nx_alloc + gb->gridbox.nx_alloc/2) ;
+      n = max(n, 1) ;
+      gb->gridbox.max_wids = XTREALLOC(gb->gridbox.max_wids, n, int) ;
+      gb->gridbox.wids = XTREALLOC(gb->gridbox.wids, n, int) ;
+      gb->gridbox.max_weightx = XTREALLOC(gb->gridbox.max_weightx, n, int) ;
+      gb->gridbox.nx_alloc = n ;
+    }
+    if( nr > gb->gridbox.ny_alloc || gb->gridbox.max_hgts == NULL )
+    {
+      n = max(nr, gb->gridbox.ny_alloc + gb->gridbox.ny_alloc/2) ;
+      n = max(n, 1) ;
+      gb->gridbox.max_hgts = XTREALLOC(gb->gridbox.max_hgts, n, int) ;
+      gb->gridbox.hgts = XTREALLOC(gb->gridbox.hgts, n, int) ;
+      gb->gridbox.max_weighty = XTREALLOC(gb->gridbox.max_weighty, n, int) ;
+      gb->gridbox.ny_alloc = n ;
+    }
+
+    if( nc > gb->gridbox.nx ) {
+      n = nc - gb->gridbox.nx ;
+      memset(gb->gridbox.max_wids + gb->gridbox.nx, 0, n*sizeof(int)) ;
+      memset(gb->gridbox.wids + gb->gridbox.nx, 0, n*sizeof(int)) ;
+      memset(gb->gridbox.max_weightx + gb->gridbox.nx, 0, n*sizeof(int)) ;
+    }
+    if( nr > gb->gridbox.ny ) {
+      n = nr - gb->gridbox.ny ;
+      memset(gb->gridbox.max_hgts + gb->gridbox.ny, 0, n*sizeof(int)) ;
+      memset(gb->gridbox.hgts + gb->gridbox.ny, 0, n*sizeof(int)) ;
+      memset(gb->gridbox.max_weighty + gb->gridbox.ny, 0, n*sizeof(int)) ;
+    }
+
+    gb->gridbox.nx = nc ;
+    gb->gridbox.ny = nr ;
 }
 
 static	void
@@ -903,6 +2282,7 @@ freeAll(gb)
     XtFree((char *)gb->gridbox.hgts) ;		gb->gridbox.hgts = NULL ;
     XtFree((char *)gb->gridbox.max_weightx) ;	gb->gridbox.max_weightx = NULL;
     XtFree((char *)gb->gridbox.max_weighty) ;	gb->gridbox.max_weighty = NULL;
+    gb->gridbox.nx_alloc = gb->gridbox.ny_alloc = 0 ;
 }
 
 
@@ -935,16 +2315,19 @@ computeWidHgtInfo(gb)
     if( gb->composite.num_children <= 0 )
       return ;
 
-    freeAll(gb) ;		/* start with clean slate */
+    PROBE4(info_start, gb, gb->composite.num_children,
+	gb->gridbox.nx, gb->gridbox.ny) ;
 
     /* step 2:	Find out how many rows & columns there will be.
      */
 
     for( i = gb->composite.num_children, childP = gb->composite.children;
 	--i >= 0; ++childP)
-      if( XtIsManaged(*childP) )
+    {
+      gc = (GridboxConstraints) (*childP)->core.constraints ;
+      gc->gridbox.counted = XtIsManaged(*childP) ;
+      if( gc->gridbox.counted )
       {
-	gc = (GridboxConstraints) (*childP)->core.constraints ;
 
 	if( gc->gridbox.gridWidth > maxgw )
 	  maxgw = gc->gridbox.gridWidth ;
@@ -956,13 +2339,12 @@ computeWidHgtInfo(gb)
 	if( gc->gridbox.gridy + gc->gridbox.gridHeight > nr )
 	  nr = gc->gridbox.gridy + gc->gridbox.gridHeight ;
       }
+    }
 
-    gb->gridbox.nx = nc ;
-    gb->gridbox.ny = nr ;
     gb->gridbox.maxgw = maxgw ;
     gb->gridbox.maxgh = maxgh ;
 
-    allocAll(gb) ;
+    allocAll(gb, nc, nr) ;	/* arrays are cleared below */
 
 
     /* step 3 & 4, examine children for the size they need,
@@ -970,6 +2352,9 @@ computeWidHgtInfo(gb)
      */
 
     computeWidHgtMax(gb) ;
+
+    PROBE4(info_done, gb, gb->composite.num_children,
+	gb->gridbox.nx, gb->gridbox.ny) ;
 }
 
 
@@ -1002,7 +2387,7 @@ computeWidHgtMax(gb)
     Widget	*childP ;
     int		i,j ;
     int		nc=0, nr=0 ;
-    Dimension	*wids, *hgts ;
+    int		*wids, *hgts ;
     int		*weightx, *weighty ;
     int		maxgw=0, maxgh=0 ;	/* max size in cells */
     GridboxConstraints	gc ;
@@ -1010,6 +2395,18 @@ computeWidHgtMax(gb)
     if( gb->composite.num_children <= 0 )
       return ;
 
+    ++gb->gridbox.generation ;
+
+    PROBE4(max_start, gb, gb->composite.num_children,
+	gb->gridbox.nx, gb->gridbox.ny) ;
+
+    if( gb->gridbox.homogeneous ) {
+      computeUniformMax(gb) ;
+      PROBE4(max_done, gb, gb->composite.num_children,
+	  gb->gridbox.nx, gb->gridbox.ny) ;
+      return ;
+    }
+
     nc = gb->gridbox.nx ;
     nr = gb->gridbox.ny ;
     maxgw = gb->gridbox.maxgw ;
@@ -1031,7 +2428,8 @@ computeWidHgtMax(gb)
      */
 
     /* Column widths */
-    memset(wids, 0, nc * sizeof(Dimension)) ;
+    memset(wids, 0, nc * sizeof(int)) ;
+    memset(weightx, 0, nc * sizeof(int)) ;
     for(j=1; j<=maxgw; ++j)
     {
       for( i=0, childP = gb->composite.children;
@@ -1040,14 +2438,17 @@ computeWidHgtMax(gb)
 	if( XtIsManaged(*childP) )
 	{
 	  gc = (GridboxConstraints) (*childP)->core.constraints ;
-	  if( gc->gridbox.gridWidth == j )
+	  if( gc->gridbox.gridWidth == j  &&
+	      fixedSize(gb->gridbox.col_tracks, gb->gridbox.ncol_tracks,
+		  gc->gridbox.gridx, gc->gridbox.gridWidth) == 0 )
 	    computeWidHgtUtil(gc->gridbox.gridx, gc->gridbox.gridWidth,
 		  gc->gridbox.prefWidth, gc->gridbox.weightx, wids, weightx) ;
 	}
     }
 
     /* column heights */
-    memset(hgts, 0, nr * sizeof(Dimension)) ;
+    memset(hgts, 0, nr * sizeof(int)) ;
+    memset(weighty, 0, nr * sizeof(int)) ;
     for(j=1; j<=maxgh; ++j)
     {
       for( i=0, childP = gb->composite.children;
@@ -1056,20 +2457,95 @@ computeWidHgtMax(gb)
 	if( XtIsManaged(*childP) )
 	{
 	  gc = (GridboxConstraints) (*childP)->core.constraints ;
-	  if( gc->gridbox.gridHeight == j )
+	  if( gc->gridbox.gridHeight == j  &&
+	      fixedSize(gb->gridbox.row_tracks, gb->gridbox.nrow_tracks,
+		  gc->gridbox.gridy, gc->gridbox.gridHeight) == 0 )
 	    computeWidHgtUtil(gc->gridbox.gridy, gc->gridbox.gridHeight,
 		  gc->gridbox.prefHeight, gc->gridbox.weighty, hgts, weighty) ;
 	}
     }
 
+    computeTotals(gb) ;
+
+    PROBE4(max_done, gb, gb->composite.num_children,
+	gb->gridbox.nx, gb->gridbox.ny) ;
+}
+
+
+
+	/* Apply the row & column declarations and size groups to
+	 * max_wids etc., and compute our preferred size.
+	 */
+
+static	void
+computeTotals(gb)
+    GridboxWidget	gb ;
+{
+    int		i ;
+    int		nc = gb->gridbox.nx ;
+    int		nr = gb->gridbox.ny ;
+    int		*wids = gb->gridbox.max_wids ;
+    int		*hgts = gb->gridbox.max_hgts ;
+    int		*weightx = gb->gridbox.max_weightx ;
+    int		*weighty = gb->gridbox.max_weighty ;
+
+    /* Apply row & column declarations */
+
+    for(i=0; i < nc && i < gb->gridbox.ncol_tracks; ++i) {
+      if( TrackFixed(&gb->gridbox.col_tracks[i]) ||
+	  gb->gridbox.col_tracks[i].collapsed )
+	weightx[i] = 0 ;
+      else if( gb->gridbox.col_tracks[i].weight != GRIDBOX_DEFAULT )
+	weightx[i] = gb->gridbox.col_tracks[i].weight ;
+    }
+    clampTracks(gb->gridbox.col_tracks, gb->gridbox.ncol_tracks, wids, nc) ;
+
+    for(i=0; i < nr && i < gb->gridbox.nrow_tracks; ++i) {
+      if( TrackFixed(&gb->gridbox.row_tracks[i]) ||
+	  gb->gridbox.row_tracks[i].collapsed )
+	weighty[i] = 0 ;
+      else if( gb->gridbox.row_tracks[i].weight != GRIDBOX_DEFAULT )
+	weighty[i] = gb->gridbox.row_tracks[i].weight ;
+    }
+    clampTracks(gb->gridbox.row_tracks, gb->gridbox.nrow_tracks, hgts, nr) ;
+
+    if( gb->gridbox.colgroup != NULL && !gb->gridbox.homogeneous )
+      groupPublish(gb, True) ;
+    if( gb->gridbox.rowgroup != NULL && !gb->gridbox.homogeneous )
+      groupPublish(gb, False) ;
+
+    computeSums(gb) ;
+}
+
+
+	/* Step 4: compute sums.  While we're at it, note whether all
+	 * rows & columns came out the same; if so, the layout can use
+	 * the uniform shortcuts.
+	 */
+
+static	void
+computeSums(gb)
+    GridboxWidget	gb ;
+{
+    int		i ;
+    int		nc = gb->gridbox.nx ;
+    int		nr = gb->gridbox.ny ;
+    int		*wids = gb->gridbox.max_wids ;
+    int		*hgts = gb->gridbox.max_hgts ;
+    int		*weightx = gb->gridbox.max_weightx ;
+    int		*weighty = gb->gridbox.max_weighty ;
+    Bool	uniform ;
 
-    /* Step 4: compute sums */
+    uniform = gb->gridbox.maxgw <= 1 && gb->gridbox.maxgh <= 1 &&
+	gb->gridbox.ncol_tracks == 0 && gb->gridbox.nrow_tracks == 0 ;
 
     gb->gridbox.total_wid = 0 ;
     gb->gridbox.total_weightx = 0 ;
     for(i=0; i<gb->gridbox.nx; ++i) {
       gb->gridbox.total_wid += wids[i] ;
       gb->gridbox.total_weightx += weightx[i] ;
+      if( wids[i] != wids[0] || weightx[i] != weightx[0] )
+	uniform = False ;
     }
 
     gb->gridbox.total_hgt = 0 ;
@@ -1077,56 +2553,284 @@ computeWidHgtMax(gb)
     for(i=0; i<gb->gridbox.ny; ++i) {
       gb->gridbox.total_hgt += hgts[i] ;
       gb->gridbox.total_weighty += weighty[i] ;
+      if( hgts[i] != hgts[0] || weighty[i] != weighty[0] )
+	uniform = False ;
+    }
+
+    gb->gridbox.uniform = uniform && nc > 0 && nr > 0 ;
+    if( gb->gridbox.uniform ) {
+      gb->gridbox.uniform_wid = wids[0] ;
+      gb->gridbox.uniform_hgt = hgts[0] ;
     }
 }
 
 
 
+	/* Homogeneous version of computeWidHgtMax().  All rows & columns
+	 * are the same size, so this is just one pass through the
+	 * children to find the largest cell size and weight.  Children
+	 * which span several cells need only 1/n of their size per cell.
+	 * Row & column declarations (including collapsed rows & columns)
+	 * are applied to that size, after which the tracks may differ.
+	 */
+
 static	void
-computeWidHgtUtil(idx, ncell, wid, weight, wids, weights)
-    int			idx, ncell ;
-    int			wid, weight ;
-    Dimension		*wids ;
-    int			*weights ;
+computeUniformMax(gb)
+    GridboxWidget	gb ;
 {
-    /* 1 set the specified column weight(s) to the max of their current
-     *	 value and the weight of this widget.
-     *
-     * 2 find out if the available space in the indicated column(s)
-     *	 is enough to satisfy this widget.  If not, distribute the
-     *	 excess size by column weights.
-     *
-     *   The excess may not divide evenly into the number of cells.
-     *   The remainder will also be distributed evenly to some of the
-     *   cells.  Make a Bresenham walk to do this.
-     */
+    Widget	*childP ;
+    int		i ;
+    int		wid=0, hgt=0, wx=0, wy=0 ;
+    int		n ;
+    GridboxConstraints	gc ;
 
-    int		i, cwid = 0 ;
-    int		wtot = 0 ;		/* total weight of cells */
-    int		excess ;
-    int		rem, count ;		/* bresenham */
+    for( i=0, childP = gb->composite.children;
+	 i < gb->composite.num_children ;
+	 ++i, ++childP )
+      if( XtIsManaged(*childP) )
+      {
+	gc = (GridboxConstraints) (*childP)->core.constraints ;
 
-    if( ncell == 1 )		/* simple case */
+	n = max(gc->gridbox.gridWidth, 1) ;
+	if( fixedSize(gb->gridbox.col_tracks, gb->gridbox.ncol_tracks,
+		gc->gridbox.gridx, gc->gridbox.gridWidth) == 0 )
+	  wid = max(wid, (gc->gridbox.prefWidth + n-1) / n) ;
+	n = max(gc->gridbox.gridHeight, 1) ;
+	if( fixedSize(gb->gridbox.row_tracks, gb->gridbox.nrow_tracks,
+		gc->gridbox.gridy, gc->gridbox.gridHeight) == 0 )
+	  hgt = max(hgt, (gc->gridbox.prefHeight + n-1) / n) ;
+	wx = max(wx, gc->gridbox.weightx) ;
+	wy = max(wy, gc->gridbox.weighty) ;
+      }
+
+    if( gb->gridbox.ncol_tracks > 0 || gb->gridbox.nrow_tracks > 0 )
     {
-      if( weights[idx] < weight ) weights[idx] = weight ;
-      if( wids[idx] < wid ) wids[idx] = wid ;
+      for(i=0; i < gb->gridbox.nx; ++i) {
+	gb->gridbox.max_wids[i] = wid ;
+	gb->gridbox.max_weightx[i] = wx ;
+      }
+      for(i=0; i < gb->gridbox.ny; ++i) {
+	gb->gridbox.max_hgts[i] = hgt ;
+	gb->gridbox.max_weighty[i] = wy ;
+      }
+      computeTotals(gb) ;
       return ;
     }
 
+    gb->gridbox.uniform = True ;
+    gb->gridbox.uniform_wid = wid ;
+    gb->gridbox.uniform_hgt = hgt ;
+    gb->gridbox.total_wid = wid * gb->gridbox.nx ;
+    gb->gridbox.total_hgt = hgt * gb->gridbox.ny ;
+    gb->gridbox.total_weightx = wx * gb->gridbox.nx ;
+    gb->gridbox.total_weighty = wy * gb->gridbox.ny ;
+}
 
-    for(i=0; i<ncell; ++i)	/* multi-cell cases */
-    {
-      assert(idx+i >= 0) ;
-      if( weights[idx+i] < weight )
-	weights[idx+i] = weight ;
-      cwid += wids[idx+i] ;
-      wtot += weights[idx+i] ;
-    }
 
-    if( cwid < wid )		/* need to increase cell size(s) */
-    {
-      excess = wid - cwid ;
-      if( ncell == 1 )		/* one cell: assign excess to the cell */
+
+	/* Incremental version of computeWidHgtInfo(), for when only the
+	 * set of managed children has changed.  Children managed since the
+	 * last computation are added to their rows & columns.  For children
+	 * which have been unmanaged, only the rows & columns in which they
+	 * were the largest (or had the most weight) are recomputed, and
+	 * empty rows & columns at the end of the grid are trimmed.  No child
+	 * is queried, and the arrays are only reallocated if the grid grows.
+	 *
+	 * If 'gone' is not NULL, that child is taken out as if it had been
+	 * unmanaged; this is used to move a child.
+	 *
+	 * This only works if every child occupies a single cell; a multi-cell
+	 * child's contribution depends on its neighbors.  Returns False if
+	 * computeWidHgtInfo() must be called instead.
+	 */
+
+static	Bool
+updateTracks(gb, gone)
+    GridboxWidget	gb ;
+    Widget		gone ;
+{
+    Widget	*childP ;
+    int		i, x, y ;
+    Bool	managed ;
+    int		nc = gb->gridbox.nx, nr = gb->gridbox.ny ;
+    Bool	removed = False, trim = False ;
+    char	*xdirty, *ydirty ;
+    GridboxConstraints	gc ;
+
+    if( gb->gridbox.homogeneous ||
+	gb->gridbox.maxgw > 1 || gb->gridbox.maxgh > 1 )
+      return False ;
+
+    groupRestore(gb) ;
+
+    /* Are all the changes simple?  How big does the grid get? */
+
+    for( i=0, childP = gb->composite.children;
+	 i < gb->composite.num_children ;
+	 ++i, ++childP )
+    {
+      gc = (GridboxConstraints) (*childP)->core.constraints ;
+      managed = XtIsManaged(*childP) && *childP != gone ;
+      if( managed == gc->gridbox.counted )
+	continue ;
+      x = gc->gridbox.gridx ;
+      y = gc->gridbox.gridy ;
+      if( gc->gridbox.gridWidth != 1 || gc->gridbox.gridHeight != 1 ||
+	  x < 0 || y < 0 )
+	return False ;
+      if( gc->gridbox.counted ) {
+	if( x >= gb->gridbox.nx || y >= gb->gridbox.ny )
+	  return False ;
+	removed = True ;
+	if( x == gb->gridbox.nx-1 || y == gb->gridbox.ny-1 )
+	  trim = True ;
+      }
+      else {
+	nc = max(nc, x+1) ;
+	nr = max(nr, y+1) ;
+      }
+    }
+
+    allocAll(gb, nc, nr) ;
+    xdirty = XtCalloc(max(nc,1), 1) ;
+    ydirty = XtCalloc(max(nr,1), 1) ;
+
+    for( i=0, childP = gb->composite.children;
+	 i < gb->composite.num_children ;
+	 ++i, ++childP )
+    {
+      gc = (GridboxConstraints) (*childP)->core.constraints ;
+      managed = XtIsManaged(*childP) && *childP != gone ;
+      if( managed == gc->gridbox.counted )
+	continue ;
+      x = gc->gridbox.gridx ;
+      y = gc->gridbox.gridy ;
+      if( gc->gridbox.counted )
+      {
+	if( gc->gridbox.prefWidth >= gb->gridbox.max_wids[x] ||
+	    (gc->gridbox.weightx > 0 &&
+	     gc->gridbox.weightx >= gb->gridbox.max_weightx[x]) )
+	  xdirty[x] = 1 ;
+	if( gc->gridbox.prefHeight >= gb->gridbox.max_hgts[y] ||
+	    (gc->gridbox.weighty > 0 &&
+	     gc->gridbox.weighty >= gb->gridbox.max_weighty[y]) )
+	  ydirty[y] = 1 ;
+	gc->gridbox.counted = False ;
+	if( !XtIsManaged(*childP) )
+	  gc->gridbox.prefs_valid = False ;	/* query again if remanaged */
+      }
+      else
+      {
+	if( fixedSize(gb->gridbox.col_tracks, gb->gridbox.ncol_tracks,
+		x, 1) == 0 )
+	  computeWidHgtUtil(x, 1, gc->gridbox.prefWidth, gc->gridbox.weightx,
+		gb->gridbox.max_wids, gb->gridbox.max_weightx) ;
+	if( fixedSize(gb->gridbox.row_tracks, gb->gridbox.nrow_tracks,
+		y, 1) == 0 )
+	  computeWidHgtUtil(y, 1, gc->gridbox.prefHeight, gc->gridbox.weighty,
+		gb->gridbox.max_hgts, gb->gridbox.max_weighty) ;
+	gc->gridbox.counted = True ;
+      }
+    }
+
+    /* Recompute the rows & columns which lost their largest child,
+     * and find the new extent of the grid.
+     */
+
+    if( removed )
+    {
+      for(x=0; x < nc; ++x)
+	if( xdirty[x] )
+	  gb->gridbox.max_wids[x] = gb->gridbox.max_weightx[x] = 0 ;
+      for(y=0; y < nr; ++y)
+	if( ydirty[y] )
+	  gb->gridbox.max_hgts[y] = gb->gridbox.max_weighty[y] = 0 ;
+
+      if( trim )
+	nc = nr = 0 ;
+
+      for( i=0, childP = gb->composite.children;
+	   i < gb->composite.num_children ;
+	   ++i, ++childP )
+	if( XtIsManaged(*childP) && *childP != gone )
+	{
+	  gc = (GridboxConstraints) (*childP)->core.constraints ;
+	  x = gc->gridbox.gridx ;
+	  y = gc->gridbox.gridy ;
+	  if( xdirty[x] && fixedSize(gb->gridbox.col_tracks,
+		gb->gridbox.ncol_tracks, x, 1) == 0 )
+	    computeWidHgtUtil(x, 1, gc->gridbox.prefWidth, gc->gridbox.weightx,
+		  gb->gridbox.max_wids, gb->gridbox.max_weightx) ;
+	  if( ydirty[y] && fixedSize(gb->gridbox.row_tracks,
+		gb->gridbox.nrow_tracks, y, 1) == 0 )
+	    computeWidHgtUtil(y, 1, gc->gridbox.prefHeight, gc->gridbox.weighty,
+		  gb->gridbox.max_hgts, gb->gridbox.max_weighty) ;
+	  if( trim ) {
+	    nc = max(nc, x+1) ;
+	    nr = max(nr, y+1) ;
+	  }
+	}
+
+      gb->gridbox.nx = nc ;
+      gb->gridbox.ny = nr ;
+    }
+
+    XtFree(xdirty) ;
+    XtFree(ydirty) ;
+
+    gb->gridbox.maxgw = gb->gridbox.maxgh = nc > 0 && nr > 0 ? 1 : 0 ;
+    ++gb->gridbox.generation ;
+    computeTotals(gb) ;
+    return True ;
+}
+
+
+
+static	void
+computeWidHgtUtil(idx, ncell, wid, weight, wids, weights)
+    int			idx, ncell ;
+    int			wid, weight ;
+    int			*wids ;
+    int			*weights ;
+{
+    /* 1 set the specified column weight(s) to the max of their current
+     *	 value and the weight of this widget.
+     *
+     * 2 find out if the available space in the indicated column(s)
+     *	 is enough to satisfy this widget.  If not, distribute the
+     *	 excess size by column weights.
+     *
+     *   The excess may not divide evenly into the number of cells.
+     *   The remainder will also be distributed evenly to some of the
+     *   cells.  Make a Bresenham walk to do this.
+     */
+
+    int		i, cwid = 0 ;
+    int		wtot = 0 ;		/* total weight of cells */
+    int		excess ;
+    int		rem, count ;		/* bresenham */
+
+    if( ncell == 1 )		/* simple case */
+    {
+      if( weights[idx] < weight ) weights[idx] = weight ;
+      if( wids[idx] < wid ) wids[idx] = wid ;
+      return ;
+    }
+
+
+    for(i=0; i<ncell; ++i)	/* multi-cell cases */
+    {
+      assert(idx+i >= 0) ;
+      if( weights[idx+i] < weight )
+	weights[idx+i] = weight ;
+      cwid += wids[idx+i] ;
+      wtot += weights[idx+i] ;
+    }
+
+    if( cwid < wid )		/* need to increase cell size(s) */
+    {
+      excess = wid - cwid ;
+      if( ncell == 1 )		/* one cell: assign excess to the cell */
 	wids[idx] = wid ;
 
       else if( wtot == 0 )	/* weights all zero, distribute evenly */
@@ -1163,6 +2867,57 @@ computeWidHgtUtil(idx, ncell, wid, weight, wids, weights)
 
 
 
+	/* If the indicated rows or columns are all fixed-size, return
+	 * their total size, else 0.
+	 */
+
+static	int
+fixedSize(tracks, ntracks, idx, ncell)
+    GridboxTrack	*tracks ;
+    int			ntracks ;
+    int			idx, ncell ;
+{
+    int		i, size = 0 ;
+
+    if( idx < 0 || idx + ncell > ntracks )
+      return 0 ;
+
+    for(i=0; i<ncell; ++i)
+    {
+      if( !TrackFixed(&tracks[idx+i]) )
+	return 0 ;
+      size += tracks[idx+i].maxsize ;
+    }
+    return size ;
+}
+
+
+	/* Limit row or column sizes to the declared minimum & maximum. */
+
+static	void
+clampTracks(tracks, ntracks, sizes, n)
+    GridboxTrack	*tracks ;
+    int			ntracks ;
+    int			*sizes ;
+    int			n ;
+{
+    int		i ;
+
+    for(i=0; i < n && i < ntracks; ++i)
+    {
+      if( tracks[i].collapsed ) {
+	sizes[i] = 0 ;
+	continue ;
+      }
+      if( tracks[i].maxsize > 0 && sizes[i] > tracks[i].maxsize )
+	sizes[i] = tracks[i].maxsize ;
+      if( sizes[i] < tracks[i].minsize )
+	sizes[i] = tracks[i].minsize ;
+    }
+}
+
+
+
 	/* Layout function.  Given a width & height, determine
 	 * sizes of all the rows & columns
 	 */
@@ -1172,167 +2927,698 @@ layout(gb, width, height)
     GridboxWidget gb ;
     int		width, height ;
 {
-    int		i,j ;
-    int		excess ;
-    int		weight ;
-    Dimension	*wids, *hgts ;
     int		mincellsize = gb->gridbox.defaultDistance * 2 + 1 ;
 
     if( gb->gridbox.nx <= 0 || gb->gridbox.ny <= 0 )
       return ;
 
-    /* find out how much excess there is */
+    PROBE5(layout_start, gb, width, height, gb->gridbox.nx, gb->gridbox.ny) ;
 
-    wids =  gb->gridbox.wids ;
-    memcpy(wids, gb->gridbox.max_wids, gb->gridbox.nx * sizeof(Dimension)) ;
-    excess = width - gb->gridbox.total_wid ;
-    weight = gb->gridbox.total_weightx ;
+    /* Uniform grid:  all columns get the same share of the excess,
+     * so there's only one width and one height to compute.
+     */
+    if( gb->gridbox.uniform )
+    {
+      uniformAxis(gb->gridbox.nx, gb->gridbox.uniform_wid,
+	width - gb->gridbox.total_wid, gb->gridbox.total_weightx,
+	mincellsize, &gb->gridbox.cell_wid, &gb->gridbox.cell_xspare) ;
+      uniformAxis(gb->gridbox.ny, gb->gridbox.uniform_hgt,
+	height - gb->gridbox.total_hgt, gb->gridbox.total_weighty,
+	mincellsize, &gb->gridbox.cell_hgt, &gb->gridbox.cell_yspare) ;
+      gb->gridbox.tracks_stale = False ;
+      PROBE5(layout_done, gb, width, height, gb->gridbox.nx, gb->gridbox.ny);
+      return ;
+    }
 
-    /* distribute excess to the columns & assign positions */
-    if( weight > 0 )
-      for(i=0; i < gb->gridbox.nx; ++i)
-	if( gb->gridbox.max_weightx[i] > 0 )
-	{
-	  j = wids[i] + gb->gridbox.max_weightx[i]*excess/weight ;
-	  wids[i] = max(j,mincellsize) ;
-	}
+    /* find out how much excess there is, distribute it to the columns */
+
+    layoutAxis(gb->gridbox.nx, gb->gridbox.max_wids, gb->gridbox.max_weightx,
+	width - gb->gridbox.total_wid, gb->gridbox.total_weightx, mincellsize,
+	gb->gridbox.col_tracks, gb->gridbox.ncol_tracks, gb->gridbox.wids) ;
 
     /* Same again, for heights */
-    hgts = gb->gridbox.hgts ;
-    memcpy(hgts, gb->gridbox.max_hgts, gb->gridbox.ny * sizeof(Dimension)) ;
-    excess = height - gb->gridbox.total_hgt ;
-    weight = gb->gridbox.total_weighty ;
 
-    /* distribute it to the rows */
+    layoutAxis(gb->gridbox.ny, gb->gridbox.max_hgts, gb->gridbox.max_weighty,
+	height - gb->gridbox.total_hgt, gb->gridbox.total_weighty, mincellsize,
+	gb->gridbox.row_tracks, gb->gridbox.nrow_tracks, gb->gridbox.hgts) ;
+
+    gb->gridbox.tracks_stale = False ;
+    PROBE5(layout_done, gb, width, height, gb->gridbox.nx, gb->gridbox.ny) ;
+}
+
+
+
+	/* The same as layoutAxis(), for n tracks of equal size and
+	 * weight.  Each track gets excess/n, rounded up or down as
+	 * layoutAxis() would; the edges are then given by ColumnEdge()
+	 * and RowEdge().  If that would leave any track smaller than
+	 * mincellsize, they all are, so all are made that size.
+	 */
+
+static	void
+uniformAxis(n, size, excess, weight, mincellsize, rsize, rspare)
+    int		n, size ;
+    int		excess, weight ;
+    int		mincellsize ;
+    int		*rsize, *rspare ;	/* RETURN */
+{
+    int		smallest ;
+
+    if( n <= 0 || weight <= 0 )
+      excess = 0 ;
+    else {
+      smallest = excess / n ;
+      if( excess % n != 0 && excess < 0 )
+	--smallest ;
+      if( size + smallest < mincellsize ) {
+	size = mincellsize ;
+	excess = 0 ;
+      }
+    }
+    *rsize = size ;
+    *rspare = excess ;
+}
+
+
+	/* Distribute excess space to the rows or columns according to
+	 * their weights.  Each track gets the share of the excess for all
+	 * the weight up to and including it, less the share for all the
+	 * weight before it.  That way, rounding errors don't accumulate,
+	 * and the position of any track is simply its unweighted position
+	 * plus a share proportional to the weight preceding it.  See
+	 * linearLayout().
+	 */
+
+static	void
+layoutAxis(n, max_sizes, weights, excess, weight, mincellsize,
+	tracks, ntracks, sizes)
+    int		n ;
+    int		*max_sizes ;
+    int		*weights ;
+    int		excess, weight ;
+    int		mincellsize ;
+    GridboxTrack *tracks ;
+    int		ntracks ;
+    int		*sizes ;		/* RETURN */
+{
+    int		i,j ;
+    int		cweight, share, prev ;
+
+    memcpy(sizes, max_sizes, n * sizeof(int)) ;
+
     if( weight > 0 )
-      for(i=0; i < gb->gridbox.ny; ++i)
-	if( gb->gridbox.max_weighty[i] > 0 )
+      for(i=0, cweight=0, prev=0; i < n; ++i)
+	if( weights[i] > 0 )
 	{
-	  j = hgts[i] + gb->gridbox.max_weighty[i]*excess/weight ;
-	  hgts[i] = max(j,mincellsize) ;
+	  cweight += weights[i] ;
+	  share = cweight*excess/weight ;
+	  j = sizes[i] + share - prev ;
+	  sizes[i] = max(j,mincellsize) ;
+	  prev = share ;
 	}
+
+    clampTracks(tracks, ntracks, sizes, n) ;
 }
 
 
 
-	/* Given a gridbox & child, compute the size and placement of
-	 * the child within the cell.
+	/* Between changes to the layout inputs, the layout is a linear
+	 * function of the excess space, as long as no row or column
+	 * is clamped to its minimum or maximum size.  The position of each
+	 * cell edge is its position at zero excess, plus
+	 * excess * (weight of the preceding tracks) / (total weight),
+	 * so computeSlopes() saves those two values for each edge of each
+	 * child.  Then each resize is a little arithmetic per child,
+	 * with no row or column computations at all.
+	 *
+	 * Clamping can't happen with positive excess unless a weighted
+	 * track has a maximum size or starts out below the minimum cell
+	 * size, so the fast path is limited to those cases.
 	 */
 
 static	void
-layoutChild(gb, w, rwid,rhgt, rx,ry)
+computeSlopes(gb)
     GridboxWidget	gb ;
-    Widget		w ;
-    Dimension		*rwid, *rhgt ;
-    Position		*rx, *ry ;
 {
-    GridboxConstraints gc = (GridboxConstraints)w->core.constraints;
-    Dimension	width, height;
-    int		margin ;
-    int		excess ;
-
-    if( !XtIsManaged(w) )
-      return ;
+    Widget	*childP ;
+    int		i ;
+    int		*bx, *cx, *by, *cy ;
+    int		nx = gb->gridbox.nx, ny = gb->gridbox.ny ;
+    int		mincellsize = gb->gridbox.defaultDistance * 2 + 1 ;
+    Bool	ok = True ;
+    GridboxConstraints	gc ;
 
-    computeCellSize(gb, gc, &width,&height) ;
+    bx = XTCALLOC(nx+1, int) ;
+    cx = XTCALLOC(nx+1, int) ;
+    by = XTCALLOC(ny+1, int) ;
+    cy = XTCALLOC(ny+1, int) ;
 
-    /* Correct for preferred fill & alignment */
-    if( !(gc->gridbox.fill & FillWidth)	 &&
-	(excess = width - gc->gridbox.prefWidth) > 0 )
+    for(i=0; i < nx; ++i)
     {
-      switch( gc->gridbox.gravity ) {
-	case CenterGravity: case NorthGravity: case SouthGravity:
-	  *rx += excess/2 ;
-	  break ;
-	case EastGravity: case NorthEastGravity: case SouthEastGravity:
-	  *rx += excess ;
-	  break ;
-      }
-      width = gc->gridbox.prefWidth ;
+      bx[i+1] = bx[i] + gb->gridbox.max_wids[i] ;
+      cx[i+1] = cx[i] + gb->gridbox.max_weightx[i] ;
+      if( gb->gridbox.max_weightx[i] > 0  &&
+	  (gb->gridbox.max_wids[i] < mincellsize ||
+	   (i < gb->gridbox.ncol_tracks && gb->gridbox.col_tracks[i].maxsize)) )
+	ok = False ;
     }
 
-    if( !(gc->gridbox.fill & FillHeight)  &&
-	(excess = height - gc->gridbox.prefHeight) > 0 )
+    for(i=0; i < ny; ++i)
     {
-      switch( gc->gridbox.gravity ) {
-	case CenterGravity: case WestGravity: case EastGravity:
-	  *ry += excess/2 ;
-	  break ;
-	case SouthGravity: case SouthWestGravity: case SouthEastGravity:
-	  *ry += excess ;
-	  break ;
-      }
-      height = gc->gridbox.prefHeight ;
+      by[i+1] = by[i] + gb->gridbox.max_hgts[i] ;
+      cy[i+1] = cy[i] + gb->gridbox.max_weighty[i] ;
+      if( gb->gridbox.max_weighty[i] > 0  &&
+	  (gb->gridbox.max_hgts[i] < mincellsize ||
+	   (i < gb->gridbox.nrow_tracks && gb->gridbox.row_tracks[i].maxsize)) )
+	ok = False ;
     }
 
-    margin = gc->gridbox.margin ;
+    for( i=0, childP = gb->composite.children;
+	 i < gb->composite.num_children ;
+	 ++i, ++childP )
+      if( XtIsManaged(*childP) )
+      {
+	gc = (GridboxConstraints) (*childP)->core.constraints ;
+	gc->gridbox.lin_x0 = bx[gc->gridbox.gridx] ;
+	gc->gridbox.lin_wx0 = cx[gc->gridbox.gridx] ;
+	gc->gridbox.lin_x1 = bx[gc->gridbox.gridx + gc->gridbox.gridWidth] ;
+	gc->gridbox.lin_wx1 = cx[gc->gridbox.gridx + gc->gridbox.gridWidth] ;
+	gc->gridbox.lin_y0 = by[gc->gridbox.gridy] ;
+	gc->gridbox.lin_wy0 = cy[gc->gridbox.gridy] ;
+	gc->gridbox.lin_y1 = by[gc->gridbox.gridy + gc->gridbox.gridHeight] ;
+	gc->gridbox.lin_wy1 = cy[gc->gridbox.gridy + gc->gridbox.gridHeight] ;
+      }
 
-    width -= 2 * w->core.border_width + 2 * margin ;
-    height -= 2 * w->core.border_width + 2 * margin ;
-    *rwid = max(width,1) ;
-    *rhgt = max(height,1) ;
-}
+    XtFree((char *)bx) ;
+    XtFree((char *)cx) ;
+    XtFree((char *)by) ;
+    XtFree((char *)cy) ;
 
+    gb->gridbox.linear_ok = ok ;
+    gb->gridbox.slope_generation = gb->gridbox.generation ;
+}
 
 
 
-	/* Make size change request.  Always return the resulting size.	 */
+	/* Lay out the children directly from their slopes.  Returns
+	 * False if the fast path doesn't apply.  Row & column sizes are
+	 * not computed; they're marked stale for computeCellSize().
+	 */
 
-static	XtGeometryResult
-changeGeometry(gb, req_width,req_height, queryOnly, reply)
+static	Bool
+linearLayout(gb)
     GridboxWidget	gb ;
-    int			req_width, req_height ;
-    int			queryOnly ;
-    XtWidgetGeometry	*reply ;
 {
-    XtGeometryResult	result ;
-    Dimension	old_width = gb->core.width, old_height = gb->core.height;
+    WidgetList	children = gb->composite.children;
+    int		num_children = gb->composite.num_children;
+    Widget	*childP;
+    int		ex, ey ;
+    int		wx = gb->gridbox.total_weightx ;
+    int		wy = gb->gridbox.total_weighty ;
+    int		x0,x1, y0,y1 ;
+    int		x, y;
+    int		width, height;
+    GridboxRect	*rect ;
+    GridboxConstraints	gc ;
 
-    if( req_width != gb->core.width  ||	 req_height != gb->core.height )
-    {
-      XtWidgetGeometry myrequest ;
+    if( gb->gridbox.uniform )
+      return False ;
 
-      myrequest.width = req_width ;
-      myrequest.height = req_height ;
-      myrequest.request_mode = CWWidth | CWHeight ;
-      if( queryOnly )
-	myrequest.request_mode |= XtCWQueryOnly ;
+    ex = gb->core.width - gb->gridbox.total_wid ;
+    ey = gb->core.height - gb->gridbox.total_hgt ;
+    if( ex < 0 || ey < 0 )
+      return False ;
 
-      result = XtMakeGeometryRequest((Widget)gb, &myrequest, reply) ;
+    if( gb->gridbox.slope_generation != gb->gridbox.generation )
+      computeSlopes(gb) ;
+    if( !gb->gridbox.linear_ok )
+      return False ;
 
-      /* BUG.  The Athena box widget (and probably others) will change
-       * our dimensions even if this is only a query.  To work around that
-       * bug, we restore our dimensions after such a query.
-       */
-      if( queryOnly ) {
-	gb->core.width = old_width ;
-	gb->core.height = old_height ;
-      }
-    }
-    else
-      result = XtGeometryNo ;
+    rect = growScratch(gb)->gridbox.scratch_rects ;
+    for (childP = children; childP - children < num_children; childP++)
+      if( XtIsManaged(*childP) )
+      {
+	gc = (GridboxConstraints)(*childP)->core.constraints;
 
-    if( reply != NULL )
-      switch( result ) {
-	case XtGeometryYes:
-	case XtGeometryDone:
-	  reply->width = req_width ;
-	  reply->height = req_height ;
-	  break ;
-	case XtGeometryNo:
-	  reply->width = old_width ;
-	  reply->height = old_height ;
-	  break ;
-	case XtGeometryAlmost:
-	  break ;
+	x0 = gc->gridbox.lin_x0 ;  x1 = gc->gridbox.lin_x1 ;
+	if( wx > 0 ) {
+	  x0 += gc->gridbox.lin_wx0 * ex / wx ;
+	  x1 += gc->gridbox.lin_wx1 * ex / wx ;
+	}
+	y0 = gc->gridbox.lin_y0 ;  y1 = gc->gridbox.lin_y1 ;
+	if( wy > 0 ) {
+	  y0 += gc->gridbox.lin_wy0 * ey / wy ;
+	  y1 += gc->gridbox.lin_wy1 * ey / wy ;
+	}
+
+	x = x0 + gc->gridbox.margin ;
+	y = y0 + gc->gridbox.margin ;
+	placeChild(*childP, x1-x0, y1-y0, &width, &height, &x, &y) ;
+
+	rect->x = ToPosition(x) ; rect->y = ToPosition(y) ;
+	rect->width = ToDimension(width) ; rect->height = ToDimension(height) ;
+	++rect ;
       }
+    applyRects(gb, gb->gridbox.scratch_rects) ;
 
-    return result ;
+    gb->gridbox.tracks_stale = True ;
+    return True ;
 }
 
 
 
-
+	/* Will a child's new preferred size leave the size of every
+	 * row & column the same?  Only single-cell children are
+	 * considered, and only if they weren't the largest in their
+	 * row or column:  otherwise finding out would mean looking at
+	 * all the other children.
+	 */
+
+static	Bool
+fitsTracks(gb, gc, old_w, old_h)
+    GridboxWidget	gb ;
+    GridboxConstraints	gc ;
+    int			old_w, old_h ;
+{
+    if( gb->gridbox.homogeneous || !gc->gridbox.counted ||
+	gb->gridbox.colgroup != NULL || gb->gridbox.rowgroup != NULL )
+      return False ;
+
+    return fitsAxis(gb->gridbox.max_wids, gb->gridbox.nx,
+		gb->gridbox.col_tracks, gb->gridbox.ncol_tracks,
+		gc->gridbox.gridx, gc->gridbox.gridWidth,
+		old_w, gc->gridbox.prefWidth)  &&
+	   fitsAxis(gb->gridbox.max_hgts, gb->gridbox.ny,
+		gb->gridbox.row_tracks, gb->gridbox.nrow_tracks,
+		gc->gridbox.gridy, gc->gridbox.gridHeight,
+		old_h, gc->gridbox.prefHeight) ;
+}
+
+
+static	Bool
+fitsAxis(sizes, n, tracks, ntracks, idx, span, old, new)
+    int			*sizes ;
+    int			n ;
+    GridboxTrack	*tracks ;
+    int			ntracks ;
+    int			idx, span ;
+    int			old, new ;
+{
+    if( new == old ||
+	fixedSize(tracks, ntracks, idx, span) > 0 )
+      return True ;
+    if( sizes == NULL || span != 1 || idx < 0 || idx >= n )
+      return False ;
+    return new <= sizes[idx] && old < sizes[idx] ;
+}
+
+
+	/* Return the position of a child's cell, plus its margin. */
+
+static	void
+cellOrigin(gb, gc, rx, ry)
+    GridboxWidget	gb ;
+    GridboxConstraints	gc ;
+    int			*rx, *ry ;
+{
+    int		i, x, y ;
+
+    if( gb->gridbox.tracks_stale )
+      layout(gb, gb->core.width, gb->core.height) ;
+
+    if( gb->gridbox.uniform ) {
+      x = ColumnEdge(gb, gc->gridbox.gridx) ;
+      y = RowEdge(gb, gc->gridbox.gridy) ;
+    }
+    else {
+      for(i=0, x=0; i < gc->gridbox.gridx; ++i)
+	x += gb->gridbox.wids[i] ;
+      for(i=0, y=0; i < gc->gridbox.gridy; ++i)
+	y += gb->gridbox.hgts[i] ;
+    }
+
+    *rx = x + gc->gridbox.margin ;
+    *ry = y + gc->gridbox.margin ;
+}
+
+
+	/* Reconfigure one child outside of a full layout.  Cached layouts
+	 * all have the child's old geometry, so they are dropped; the
+	 * cell edges haven't moved, so the slopes stay.
+	 */
+
+static	void
+moveChild(gb, w, x, y, width, height)
+    GridboxWidget	gb ;
+    Widget		w ;
+    int			x, y, width, height ;
+{
+    GridboxRect		*old = NULL ;
+    int			i ;
+
+    for(i=0; i < GRIDBOX_CACHE_SIZE; ++i)
+      gb->gridbox.cache[i].generation = 0 ;
+
+    if( XtHasCallbacks((Widget)gb, XtNlayoutCallback) == XtCallbackHasSome )
+      old = saveGeometry(gb) ;
+
+    XtConfigureWidget(w, ToPosition(x), ToPosition(y),
+	ToDimension(width), ToDimension(height), w->core.border_width) ;
+
+    if( gb->gridbox.publishLayout )
+      publishLayout(gb, True) ;
+    if( old != NULL )
+      reportLayout(gb, old) ;
+}
+
+
+	/* Given a gridbox & child, compute the size and placement of
+	 * the child within the cell.
+	 */
+
+static	void
+layoutChild(gb, w, rwid,rhgt, rx,ry)
+    GridboxWidget	gb ;
+    Widget		w ;
+    int			*rwid, *rhgt ;
+    int			*rx, *ry ;
+{
+    GridboxConstraints gc = (GridboxConstraints)w->core.constraints;
+    int		width, height;
+
+    if( !XtIsManaged(w) )
+      return ;
+
+    computeCellSize(gb, gc, &width,&height) ;
+    placeChild(w, width, height, rwid, rhgt, rx, ry) ;
+}
+
+
+	/* Given a child and the size of its cell, compute the size and
+	 * placement of the child within the cell.
+	 */
+
+static	void
+placeChild(w, width, height, rwid,rhgt, rx,ry)
+    Widget		w ;
+    int			width, height ;
+    int			*rwid, *rhgt ;
+    int			*rx, *ry ;
+{
+    GridboxConstraints gc = (GridboxConstraints)w->core.constraints;
+    int		margin ;
+    int		excess ;
+
+    /* Correct for preferred fill & alignment */
+    if( !(gc->gridbox.fill & FillWidth)	 &&
+	(excess = width - gc->gridbox.prefWidth) > 0 )
+    {
+      switch( gc->gridbox.gravity ) {
+	case CenterGravity: case NorthGravity: case SouthGravity:
+	  *rx += excess/2 ;
+	  break ;
+	case EastGravity: case NorthEastGravity: case SouthEastGravity:
+	  *rx += excess ;
+	  break ;
+      }
+      width = gc->gridbox.prefWidth ;
+    }
+
+    if( !(gc->gridbox.fill & FillHeight)  &&
+	(excess = height - gc->gridbox.prefHeight) > 0 )
+    {
+      switch( gc->gridbox.gravity ) {
+	case CenterGravity: case WestGravity: case EastGravity:
+	  *ry += excess/2 ;
+	  break ;
+	case SouthGravity: case SouthWestGravity: case SouthEastGravity:
+	  *ry += excess ;
+	  break ;
+      }
+      height = gc->gridbox.prefHeight ;
+    }
+
+    margin = gc->gridbox.margin ;
+
+    width -= 2 * w->core.border_width + 2 * margin ;
+    height -= 2 * w->core.border_width + 2 * margin ;
+    *rwid = max(width,1) ;
+    *rhgt = max(height,1) ;
+}
+
+
+
+#ifdef	DEBUG
+	/* Check the layout just done:  no row or column has negative size,
+	 * and every child lies within its cell, unless the cell is too
+	 * small to hold even a one-pixel child.
+	 */
+
+static	void
+checkLayout(gb)
+    GridboxWidget	gb ;
+{
+    Widget	*childP ;
+    int		i ;
+    int		x, y, width, height, edges ;
+    GridboxConstraints	gc ;
+
+    if( gb->gridbox.max_wids == NULL )
+      return ;
+
+    if( !gb->gridbox.uniform ) {
+      for(i=0; i < gb->gridbox.nx; ++i)
+	assert(gb->gridbox.wids[i] >= 0) ;
+      for(i=0; i < gb->gridbox.ny; ++i)
+	assert(gb->gridbox.hgts[i] >= 0) ;
+    }
+
+    for( i=0, childP = gb->composite.children;
+	 i < gb->composite.num_children ;
+	 ++i, ++childP )
+    {
+      gc = (GridboxConstraints) (*childP)->core.constraints ;
+      if( !XtIsManaged(*childP) || gc->gridbox.hidden )
+	continue ;
+
+      cellOrigin(gb, gc, &x, &y) ;
+      computeCellSize(gb, gc, &width, &height) ;
+      x -= gc->gridbox.margin ;
+      y -= gc->gridbox.margin ;
+      edges = 2 * (*childP)->core.border_width + 2 * gc->gridbox.margin ;
+
+      if( (width > edges &&
+	    ((*childP)->core.x < x ||
+	     (*childP)->core.x + (int)(*childP)->core.width + edges > x+width))
+	  ||
+	  (height > edges &&
+	    ((*childP)->core.y < y ||
+	     (*childP)->core.y + (int)(*childP)->core.height + edges > y+height)))
+	fprintf(stderr, "yak! %s at %d,%d is outside its cell %dx%d+%d+%d\n",
+	  XtName(*childP), (*childP)->core.x, (*childP)->core.y,
+	  width, height, x, y) ;
+    }
+}
+#endif	/* DEBUG */
+
+
+
+	/* Recompute row & column sizes from the children's preferred
+	 * sizes, negotiate our own size with our parent, and lay out
+	 * the children again.
+	 */
+
+static	void
+relayout(gb)
+    GridboxWidget	gb ;
+{
+    computeWidHgtInfo(gb) ;
+    fitToGrid(gb) ;
+}
+
+
+	/* Negotiate our own size for the current row & column sizes,
+	 * then lay out the children.
+	 */
+
+static	void
+fitToGrid(gb)
+    GridboxWidget	gb ;
+{
+    XtWidgetGeometry	reply ;
+    int			width, height ;
+
+    width = gb->gridbox.total_wid ;
+    height = gb->gridbox.total_hgt ;
+
+    /* ask to change geometry to accomodate; accept any compromise offered */
+    if( changeGeometry(gb, width, height, False, &reply) == XtGeometryAlmost )
+      (void) changeGeometry(gb, reply.width, reply.height, False, &reply) ;
+
+    /* always re-execute layout */
+    XtClass((Widget)gb)->core_class.resize((Widget)gb) ;
+}
+
+
+
+
+	/* LAYOUT CACHE */
+
+
+	/* Find a cached layout for the current size and layout inputs. */
+
+static	GridboxCacheEntry *
+cacheFind(gb)
+    GridboxWidget	gb ;
+{
+    GridboxCacheEntry	*entry ;
+    int			i ;
+
+    for(i=0, entry = gb->gridbox.cache; i < GRIDBOX_CACHE_SIZE; ++i, ++entry)
+      if( entry->generation == gb->gridbox.generation  &&
+	  entry->width == gb->core.width  &&
+	  entry->height == gb->core.height )
+      {
+	entry->used = ++gb->gridbox.cache_clock ;
+	return entry ;
+      }
+    return NULL ;
+}
+
+
+	/* Allocate a cache entry for the current size and layout inputs,
+	 * replacing the least recently used one.  Row & column sizes
+	 * are copied from the current layout; the caller fills in
+	 * the child rectangles.
+	 */
+
+static	GridboxCacheEntry *
+cacheNew(gb)
+    GridboxWidget	gb ;
+{
+    GridboxCacheEntry	*entry, *victim ;
+    int			i ;
+
+    victim = gb->gridbox.cache ;
+    for(i=0, entry = gb->gridbox.cache; i < GRIDBOX_CACHE_SIZE; ++i, ++entry)
+    {
+      if( entry->generation != gb->gridbox.generation ) {
+	victim = entry ;
+	break ;
+      }
+      if( entry->used < victim->used )
+	victim = entry ;
+    }
+
+    entry = victim ;
+    entry->wids = (int *)XtRealloc((char *)entry->wids,
+		      max(gb->gridbox.nx,1) * sizeof(int)) ;
+    entry->hgts = (int *)XtRealloc((char *)entry->hgts,
+		      max(gb->gridbox.ny,1) * sizeof(int)) ;
+    entry->rects = (GridboxRect *)XtRealloc((char *)entry->rects,
+		      max(gb->composite.num_children,1) * sizeof(GridboxRect)) ;
+
+    entry->width = gb->core.width ;
+    entry->height = gb->core.height ;
+    entry->generation = gb->gridbox.generation ;
+    entry->used = ++gb->gridbox.cache_clock ;
+    entry->nx = gb->gridbox.nx ;
+    entry->ny = gb->gridbox.ny ;
+    entry->nchild = 0 ;
+    if( !gb->gridbox.uniform ) {
+      memcpy(entry->wids, gb->gridbox.wids, entry->nx * sizeof(int)) ;
+      memcpy(entry->hgts, gb->gridbox.hgts, entry->ny * sizeof(int)) ;
+    }
+    entry->cell_wid = gb->gridbox.cell_wid ;
+    entry->cell_hgt = gb->gridbox.cell_hgt ;
+    entry->cell_xspare = gb->gridbox.cell_xspare ;
+    entry->cell_yspare = gb->gridbox.cell_yspare ;
+
+    return entry ;
+}
+
+
+static	void
+cacheFree(gb)
+    GridboxWidget	gb ;
+{
+    GridboxCacheEntry	*entry ;
+    int			i ;
+
+    for(i=0, entry = gb->gridbox.cache; i < GRIDBOX_CACHE_SIZE; ++i, ++entry)
+    {
+      XtFree((char *)entry->wids) ;	entry->wids = NULL ;
+      XtFree((char *)entry->hgts) ;	entry->hgts = NULL ;
+      XtFree((char *)entry->rects) ;	entry->rects = NULL ;
+      entry->generation = 0 ;
+    }
+}
+
+
+
+
+	/* Make size change request.  Always return the resulting size.	 */
+
+static	XtGeometryResult
+changeGeometry(gb, req_width,req_height, queryOnly, reply)
+    GridboxWidget	gb ;
+    int			req_width, req_height ;
+    int			queryOnly ;
+    XtWidgetGeometry	*reply ;
+{
+    XtGeometryResult	result ;
+    Dimension	old_width = gb->core.width, old_height = gb->core.height;
+
+    PROBE4(change_start, gb, req_width, req_height, queryOnly) ;
+
+    if( req_width != gb->core.width  ||	 req_height != gb->core.height )
+    {
+      XtWidgetGeometry myrequest ;
+
+      myrequest.width = ToDimension(req_width) ;
+      myrequest.height = ToDimension(req_height) ;
+      myrequest.request_mode = CWWidth | CWHeight ;
+      if( queryOnly )
+	myrequest.request_mode |= XtCWQueryOnly ;
+
+      result = XtMakeGeometryRequest((Widget)gb, &myrequest, reply) ;
+
+      /* BUG.  The Athena box widget (and probably others) will change
+       * our dimensions even if this is only a query.  To work around that
+       * bug, we restore our dimensions after such a query.
+       */
+      if( queryOnly ) {
+	gb->core.width = old_width ;
+	gb->core.height = old_height ;
+      }
+    }
+    else
+      result = XtGeometryNo ;
+
+    if( reply != NULL )
+      switch( result ) {
+	case XtGeometryYes:
+	case XtGeometryDone:
+	  reply->width = ToDimension(req_width) ;
+	  reply->height = ToDimension(req_height) ;
+	  break ;
+	case XtGeometryNo:
+	  reply->width = old_width ;
+	  reply->height = old_height ;
+	  break ;
+	case XtGeometryAlmost:
+	  break ;
+      }
+
+    PROBE4(change_done, gb, result,
+	reply != NULL ? reply->width : gb->core.width,
+	reply != NULL ? reply->height : gb->core.height) ;
+    return result ;
+}
+
+
+
+
 
 	/* RESOURCES */
 
@@ -1354,43 +3640,57 @@ changeGeometry(gb, req_width,req_height, queryOnly, reply)
 
 
 
-/* ARGSUSED */
-static	Boolean
-_CvtStringToFillType(dpy, args, num_args, fromVal, toVal, data)
-    Display	*dpy ;
-    XrmValuePtr args;		/* unused */
-    Cardinal	*num_args;	/* unused */
-    XrmValuePtr fromVal;
-    XrmValuePtr toVal;
+	/* Look up a keyword, ignoring case.  Returns NULL if
+	 * not found.  The string is lowered once, and then compared
+	 * with the short table; nothing is interned, so strings which
+	 * aren't keywords (e.g. numbers) leave nothing behind.
+	 */
+
+static	Keyword *
+findKeyword(str, keywords, nkeywords)
+    String	str ;
+    Keyword	*keywords ;
+    int		nkeywords ;
+{
+    char	lowered[MAX_KEYWORD+1] ;
+
+    if( strlen(str) > MAX_KEYWORD )
+      return NULL ;
+
+    XmuCopyISOLatin1Lowered(lowered, str) ;
+
+    for(; --nkeywords >= 0; ++keywords)
+      if( keywords->name[0] == lowered[0] &&
+	  strcmp(keywords->name, lowered) == 0 )
+	return keywords ;
+    return NULL ;
+}
+
+
+
+/* ARGSUSED */
+static	Boolean
+_CvtStringToFillType(dpy, args, num_args, fromVal, toVal, data)
+    Display	*dpy ;
+    XrmValuePtr args;		/* unused */
+    Cardinal	*num_args;	/* unused */
+    XrmValuePtr fromVal;
+    XrmValuePtr toVal;
     XtPointer	*data ;
 {
-    String	str = (String)fromVal->addr ;
-    static int	fillType;
-
-    if( XmuCompareISOLatin1(str, "none") == 0  ||
-	XmuCompareISOLatin1(str, "fillnone") == 0 )
-      fillType = FillNone ;
-    else if( XmuCompareISOLatin1(str, "width") == 0  ||
-	     XmuCompareISOLatin1(str, "fillwidth") == 0	 ||
-	     XmuCompareISOLatin1(str, "horizontal") == 0  ||
-	     XmuCompareISOLatin1(str, "x") == 0 )
-      fillType = FillWidth ;
-    else if( XmuCompareISOLatin1(str, "height") == 0  ||
-	     XmuCompareISOLatin1(str, "fillheight") == 0  ||
-	     XmuCompareISOLatin1(str, "vertical") == 0	||
-	     XmuCompareISOLatin1(str, "y") == 0 )
-      fillType = FillHeight ;
-    else if( XmuCompareISOLatin1(str, "both") == 0  ||
-	     XmuCompareISOLatin1(str, "fillboth") == 0	||
-	     XmuCompareISOLatin1(str, "all") == 0  ||
-	     XmuCompareISOLatin1(str, "xy") == 0 )
-      fillType = FillBoth ;
-    else {
+    Keyword	*kw ;
+
+    if( (kw = findKeyword((String)fromVal->addr,
+		fillKeywords, XtNumber(fillKeywords))) == NULL )
+    {
       XtStringConversionWarning(fromVal->addr, XtRFillType);
       return False ;
     }
 
-    done(int, fillType) ;
+    /* kw->value is read-only once initialized, so returning its
+     * address is safe no matter how many threads are converting.
+     */
+    done(FillType, kw->value) ;
 }
 
 
@@ -1405,18 +3705,2129 @@ _CvtStringToGridPosition(dpy, args, num_args, fromVal, toVal, data)
     XtPointer	*data ;
 {
     String	str = (String)fromVal->addr ;
-    static Position position ;
-
-    if( XmuCompareISOLatin1(str, "gridboxnext") == 0  ||
-	XmuCompareISOLatin1(str, "gridnext") == 0  ||
-	XmuCompareISOLatin1(str, "next") == 0 )
-      position = GRIDBOX_NEXT ;
-    else if( XmuCompareISOLatin1(str, "gridboxsame") == 0  ||
-	     XmuCompareISOLatin1(str, "gridsame") == 0 ||
-	     XmuCompareISOLatin1(str, "same") == 0 )
-      position = GRIDBOX_SAME ;
-    else
+    Keyword	*kw ;
+
+    /* Most positions are numbers; don't look those up at all */
+    if( isdigit((unsigned char)*str) || *str == '-' || *str == '+' ||
+	(kw = findKeyword(str,
+		positionKeywords, XtNumber(positionKeywords))) == NULL )
       return XtCvtStringToShort(dpy, args,num_args, fromVal, toVal, data) ;
 
-    done(Position, position) ;
+    done(Position, kw->position) ;
+}
+
+
+
+
+	/* ROW & COLUMN DECLARATIONS */
+
+
+	/* Parse a columnSpec or rowSpec resource into an array of
+	 * track declarations.  See Gridbox.h for the syntax.
+	 */
+
+static	void
+parseTrackSpec(spec, rtracks, rntracks)
+    String		spec ;
+    GridboxTrack	**rtracks ;
+    int			*rntracks ;
+{
+    GridboxTrack	*tracks = NULL, *t ;
+    int			n = 0 ;
+    char		*ptr = spec ;
+
+    XtFree((char *)*rtracks) ;
+
+    while( ptr != NULL && *ptr != '\0' )
+    {
+      while( isspace((unsigned char)*ptr) || *ptr == ',' )
+	++ptr ;
+      if( *ptr == '\0' )
+	break ;
+
+      tracks = (GridboxTrack *)
+	  XtRealloc((char *)tracks, (n+1) * sizeof(GridboxTrack)) ;
+      t = &tracks[n++] ;
+      t->minsize = t->maxsize = 0 ;
+      t->weight = GRIDBOX_DEFAULT ;
+      t->collapsed = False ;
+
+      if( *ptr == '*' )
+	++ptr ;
+      else
+      {
+	if( isdigit((unsigned char)*ptr) )
+	  t->minsize = t->maxsize = strtol(ptr, &ptr, 10) ;
+	if( *ptr == '-' ) {
+	  ++ptr ;
+	  t->maxsize = isdigit((unsigned char)*ptr) ? strtol(ptr, &ptr, 10) : 0 ;
+	}
+      }
+
+      if( *ptr == ':' ) {
+	++ptr ;
+	t->weight = strtol(ptr, &ptr, 10) ;
+      }
+
+      if( *ptr != '\0' && !isspace((unsigned char)*ptr) && *ptr != ',' ) {
+	XtStringConversionWarning(spec, XtCTrackSpec) ;
+	while( *ptr != '\0' && !isspace((unsigned char)*ptr) && *ptr != ',' )
+	  ++ptr ;
+      }
+    }
+
+    *rtracks = tracks ;
+    *rntracks = n ;
+}
+
+
+
+	/* Return row or column declaration idx, adding undeclared
+	 * entries to the array as needed.
+	 */
+
+static	GridboxTrack *
+extendTracks(rtracks, rntracks, idx)
+    GridboxTrack	**rtracks ;
+    int			*rntracks ;
+    int			idx ;
+{
+    GridboxTrack	*t ;
+
+    if( idx >= *rntracks )
+    {
+      *rtracks = (GridboxTrack *)
+	  XtRealloc((char *)*rtracks, (idx+1) * sizeof(GridboxTrack)) ;
+      for(t = *rtracks + *rntracks; t <= *rtracks + idx; ++t) {
+	t->minsize = t->maxsize = 0 ;
+	t->weight = GRIDBOX_DEFAULT ;
+	t->collapsed = False ;
+      }
+      *rntracks = idx+1 ;
+    }
+    return *rtracks + idx ;
+}
+
+
+static	void
+setTrack(gb, rtracks, rntracks, idx, minsize, maxsize, weight)
+    GridboxWidget	gb ;
+    GridboxTrack	**rtracks ;
+    int			*rntracks ;
+    int			idx ;
+    int			minsize, maxsize, weight ;
+{
+    GridboxTrack	*t ;
+
+    if( idx < 0 )
+      return ;
+
+    t = extendTracks(rtracks, rntracks, idx) ;
+    t->minsize = max(minsize, 0) ;
+    t->maxsize = max(maxsize, 0) ;
+    t->weight = weight ;
+
+    if( gb->composite.num_children > 0 && gb->gridbox.max_wids != NULL ) {
+      getPreferredSizes(gb, True) ;
+      relayout(gb) ;
+    }
+    else {
+      gb->gridbox.needs_layout = True ;
+      ++gb->gridbox.generation ;
+    }
+}
+
+
+
+void
+GridboxSetColumn(w, column, minsize, maxsize, weight)
+    Widget	w ;
+    int		column ;
+    int		minsize, maxsize, weight ;
+{
+    GridboxWidget	gb = (GridboxWidget)w ;
+
+    LockWidget(w) ;
+    setTrack(gb, &gb->gridbox.col_tracks, &gb->gridbox.ncol_tracks,
+	column, minsize, maxsize, weight) ;
+    UnlockWidget(w) ;
+}
+
+
+void
+GridboxSetRow(w, row, minsize, maxsize, weight)
+    Widget	w ;
+    int		row ;
+    int		minsize, maxsize, weight ;
+{
+    GridboxWidget	gb = (GridboxWidget)w ;
+
+    LockWidget(w) ;
+    setTrack(gb, &gb->gridbox.row_tracks, &gb->gridbox.nrow_tracks,
+	row, minsize, maxsize, weight) ;
+    UnlockWidget(w) ;
+}
+
+
+
+	/* Collapse or expand a row or column.  A collapsed row or
+	 * column has zero size, and children which lie entirely within
+	 * collapsed rows or columns are unmapped.  Nothing is queried;
+	 * expanding only recomputes the one row or column.
+	 */
+
+static	void
+collapseTrack(gb, columns, idx, collapse)
+    GridboxWidget	gb ;
+    Bool		columns ;
+    int			idx ;
+    Bool		collapse ;
+{
+    GridboxTrack	*t ;
+    Widget		*childP ;
+    int			i ;
+    GridboxConstraints	gc ;
+
+    if( idx < 0 )
+      return ;
+
+    if( columns )
+      t = extendTracks(&gb->gridbox.col_tracks, &gb->gridbox.ncol_tracks, idx);
+    else
+      t = extendTracks(&gb->gridbox.row_tracks, &gb->gridbox.nrow_tracks, idx);
+
+    if( t->collapsed == collapse )
+      return ;
+    t->collapsed = collapse ;
+    ++gb->gridbox.generation ;
+
+    if( gb->gridbox.max_wids == NULL ) {
+      gb->gridbox.needs_layout = True ;
+      return ;
+    }
+
+    groupRestore(gb) ;
+
+    /* On expand, get the size back from the children in this
+     * row or column.  In a homogeneous grid, that's the common size.
+     */
+    if( gb->gridbox.homogeneous )
+      computeWidHgtMax(gb) ;
+    else if( !collapse && idx < (columns ? gb->gridbox.nx : gb->gridbox.ny) )
+    {
+      if( (columns ? gb->gridbox.maxgw : gb->gridbox.maxgh) > 1 )
+	computeWidHgtMax(gb) ;
+      else
+      {
+	if( columns )
+	  gb->gridbox.max_wids[idx] = gb->gridbox.max_weightx[idx] = 0 ;
+	else
+	  gb->gridbox.max_hgts[idx] = gb->gridbox.max_weighty[idx] = 0 ;
+
+	for( i=0, childP = gb->composite.children;
+	     i < gb->composite.num_children ;
+	     ++i, ++childP )
+	  if( XtIsManaged(*childP) )
+	  {
+	    gc = (GridboxConstraints) (*childP)->core.constraints ;
+	    if( columns && gc->gridbox.gridx == idx &&
+		!TrackFixed(t) )
+	      computeWidHgtUtil(idx, 1, gc->gridbox.prefWidth,
+		gc->gridbox.weightx,
+		gb->gridbox.max_wids, gb->gridbox.max_weightx) ;
+	    else if( !columns && gc->gridbox.gridy == idx &&
+		!TrackFixed(t) )
+	      computeWidHgtUtil(idx, 1, gc->gridbox.prefHeight,
+		gc->gridbox.weighty,
+		gb->gridbox.max_hgts, gb->gridbox.max_weighty) ;
+	  }
+      }
+    }
+
+    computeTotals(gb) ;
+
+    if( XtIsRealized((Widget)gb) )
+      fitToGrid(gb) ;
+    else
+      gb->gridbox.needs_layout = True ;
+}
+
+
+	/* Return True if the indicated rows or columns are all collapsed. */
+
+static	Bool
+collapsedSpan(tracks, ntracks, idx, ncell)
+    GridboxTrack	*tracks ;
+    int			ntracks ;
+    int			idx, ncell ;
+{
+    int		i ;
+
+    if( idx < 0 || idx + ncell > ntracks || ncell <= 0 )
+      return False ;
+
+    for(i=0; i<ncell; ++i)
+      if( !tracks[idx+i].collapsed )
+	return False ;
+    return True ;
+}
+
+
+	/* Unmap the children in collapsed rows & columns, and map
+	 * the ones which are no longer collapsed.  This is done through
+	 * mapped_when_managed so it works whether or not they're
+	 * realized; the child's own setting is restored afterwards.
+	 * Windowless children are simply not drawn while hidden.
+	 */
+
+static	void
+showChildren(gb)
+    GridboxWidget	gb ;
+{
+    Widget		*childP ;
+    int			i ;
+    Bool		hide, any = gb->gridbox.nhidden > 0 ;
+    GridboxConstraints	gc ;
+
+    for(i=0; !any && i < gb->gridbox.ncol_tracks; ++i)
+      any = gb->gridbox.col_tracks[i].collapsed ;
+    for(i=0; !any && i < gb->gridbox.nrow_tracks; ++i)
+      any = gb->gridbox.row_tracks[i].collapsed ;
+    if( !any )
+      return ;
+
+    for( i=0, childP = gb->composite.children;
+	 i < gb->composite.num_children ;
+	 ++i, ++childP )
+    {
+      gc = (GridboxConstraints) (*childP)->core.constraints ;
+      hide = XtIsManaged(*childP) && (
+	  collapsedSpan(gb->gridbox.col_tracks, gb->gridbox.ncol_tracks,
+		gc->gridbox.gridx, gc->gridbox.gridWidth) ||
+	  collapsedSpan(gb->gridbox.row_tracks, gb->gridbox.nrow_tracks,
+		gc->gridbox.gridy, gc->gridbox.gridHeight) ) ;
+
+      if( hide && !gc->gridbox.hidden ) {
+	if( XtIsWidget(*childP) ) {
+	  gc->gridbox.mapped = (*childP)->core.mapped_when_managed ;
+	  XtSetMappedWhenManaged(*childP, False) ;
+	}
+	gc->gridbox.hidden = True ;
+	++gb->gridbox.nhidden ;
+      }
+      else if( !hide && gc->gridbox.hidden && XtIsManaged(*childP) ) {
+	if( XtIsWidget(*childP) )
+	  XtSetMappedWhenManaged(*childP, gc->gridbox.mapped) ;
+	gc->gridbox.hidden = False ;
+	--gb->gridbox.nhidden ;
+      }
+    }
+}
+
+
+void
+GridboxCollapseColumn(w, column, collapse)
+    Widget	w ;
+    int		column ;
+    Bool	collapse ;
+{
+    LockWidget(w) ;
+    collapseTrack((GridboxWidget)w, True, column, collapse) ;
+    UnlockWidget(w) ;
+}
+
+
+void
+GridboxCollapseRow(w, row, collapse)
+    Widget	w ;
+    int		row ;
+    Bool	collapse ;
+{
+    LockWidget(w) ;
+    collapseTrack((GridboxWidget)w, False, row, collapse) ;
+    UnlockWidget(w) ;
+}
+
+
+
+	/* Insert (n > 0) or delete (n < 0) rows or columns at idx.
+	 * Children at or beyond idx are moved in one pass, without going
+	 * through XtSetValues, and the row or column declarations move
+	 * with them.  Children which span idx grow to include inserted
+	 * rows or columns, and shrink to exclude deleted ones.  Children
+	 * entirely within deleted rows or columns are unmanaged.  The
+	 * Gridbox is laid out once when done.  If no child spans several
+	 * rows (columns), the row (column) sizes are spliced rather than
+	 * computed again.
+	 */
+
+static	void
+shiftTracks(gb, columns, idx, n)
+    GridboxWidget	gb ;
+    Bool		columns ;
+    int			idx, n ;
+{
+    Widget		*childP ;
+    WidgetList		doomed ;
+    int			ndoomed = 0 ;
+    int			i ;
+    int			top, bot, end ;
+    Position		*pos ;
+    Dimension		*span ;
+    GridboxTrack	**rtracks ;
+    int			*rntracks ;
+    GridboxConstraints	gc ;
+
+    if( idx < 0 || n == 0 )
+      return ;
+
+    end = idx - n ;		/* end of deleted range */
+    doomed = (WidgetList) XtMalloc(
+		max(gb->composite.num_children,1) * sizeof(Widget)) ;
+
+    for( i=0, childP = gb->composite.children;
+	 i < gb->composite.num_children ;
+	 ++i, ++childP )
+    {
+      gc = (GridboxConstraints) (*childP)->core.constraints ;
+      if( columns ) {
+	pos = &gc->gridbox.gridx ;
+	span = &gc->gridbox.gridWidth ;
+      } else {
+	pos = &gc->gridbox.gridy ;
+	span = &gc->gridbox.gridHeight ;
+      }
+      if( *pos < 0 )		/* GRIDBOX_NEXT or GRIDBOX_SAME */
+	continue ;
+
+      top = *pos ;
+      bot = *pos + *span ;
+      if( n > 0 ) {
+	if( top >= idx )
+	  top += n ;
+	if( bot > idx )
+	  bot += n ;
+      }
+      else {
+	top = top < idx ? top : top >= end ? top + n : idx ;
+	bot = bot < idx ? bot : bot >= end ? bot + n : idx ;
+	if( bot <= top ) {
+	  if( XtIsManaged(*childP) )
+	    doomed[ndoomed++] = *childP ;
+	  bot = top + 1 ;
+	}
+      }
+
+      if( bot - top != *span &&
+	  (gb->gridbox.ncol_tracks > 0 || gb->gridbox.nrow_tracks > 0) )
+	gc->gridbox.prefs_valid = False ;
+      *pos = top ;
+      *span = bot - top ;
+    }
+
+
+    /* Move the declarations too */
+
+    if( columns ) {
+      rtracks = &gb->gridbox.col_tracks ;
+      rntracks = &gb->gridbox.ncol_tracks ;
+    } else {
+      rtracks = &gb->gridbox.row_tracks ;
+      rntracks = &gb->gridbox.nrow_tracks ;
+    }
+
+    if( idx < *rntracks )
+    {
+      if( n > 0 ) {
+	*rtracks = (GridboxTrack *)
+	  XtRealloc((char *)*rtracks, (*rntracks + n) * sizeof(GridboxTrack)) ;
+	memmove(*rtracks + idx + n, *rtracks + idx,
+	  (*rntracks - idx) * sizeof(GridboxTrack)) ;
+	for(i=idx; i < idx+n; ++i) {
+	  (*rtracks)[i].minsize = (*rtracks)[i].maxsize = 0 ;
+	  (*rtracks)[i].weight = GRIDBOX_DEFAULT ;
+	  (*rtracks)[i].collapsed = False ;
+	}
+	*rntracks += n ;
+      }
+      else if( end >= *rntracks )
+	*rntracks = idx ;
+      else {
+	memmove(*rtracks + idx, *rtracks + end,
+	  (*rntracks - end) * sizeof(GridboxTrack)) ;
+	*rntracks += n ;
+      }
+    }
+
+
+    /* Now lay out again.  If children are to be unmanaged, let
+     * change_managed do it; otherwise start from scratch.
+     */
+
+    ++gb->gridbox.generation ;
+    gb->gridbox.needs_layout = True ;
+
+    if( spliceTracks(gb, columns, idx, n) ) {
+      computeTotals(gb) ;
+      if( ndoomed > 0 )
+	XtUnmanageChildren(doomed, ndoomed) ;
+      else if( XtIsRealized((Widget)gb) )
+	fitToGrid(gb) ;
+    }
+    else if( ndoomed > 0 ) {
+      freeAll(gb) ;
+      XtUnmanageChildren(doomed, ndoomed) ;
+    }
+    else if( XtIsRealized((Widget)gb) && gb->gridbox.max_wids != NULL ) {
+      getPreferredSizes(gb, False) ;
+      relayout(gb) ;
+    }
+    else
+      freeAll(gb) ;
+
+    XtFree((char *)doomed) ;
+}
+
+
+	/* Insert (n > 0) or delete (n < 0) rows or columns at idx in the
+	 * sizes computed so far, for shiftTracks().  A track's size can
+	 * only be moved like this if it came from the children in that
+	 * track alone, i.e. no child spans several.  Children left in
+	 * deleted tracks are then unmanaged, which recomputes the
+	 * tracks they were in.  Returns False if the sizes must be
+	 * computed again instead.
+	 */
+
+static	Bool
+spliceTracks(gb, columns, idx, n)
+    GridboxWidget	gb ;
+    Bool		columns ;
+    int			idx, n ;
+{
+    int		nt = columns ? gb->gridbox.nx : gb->gridbox.ny ;
+    int		*sizes, *weights ;
+    int		end ;
+
+    if( gb->gridbox.max_wids == NULL || gb->gridbox.homogeneous ||
+	(columns ? gb->gridbox.maxgw : gb->gridbox.maxgh) > 1 )
+      return False ;
+
+    groupRestore(gb) ;
+
+    if( idx >= nt )
+      return True ;
+
+    if( n > 0 ) {
+      if( columns )
+	allocAll(gb, nt + n, gb->gridbox.ny) ;
+      else
+	allocAll(gb, gb->gridbox.nx, nt + n) ;
+      sizes = columns ? gb->gridbox.max_wids : gb->gridbox.max_hgts ;
+      weights = columns ? gb->gridbox.max_weightx : gb->gridbox.max_weighty ;
+      memmove(sizes + idx + n, sizes + idx, (nt - idx) * sizeof(int)) ;
+      memmove(weights + idx + n, weights + idx, (nt - idx) * sizeof(int)) ;
+      memset(sizes + idx, 0, n * sizeof(int)) ;
+      memset(weights + idx, 0, n * sizeof(int)) ;
+    }
+    else {
+      sizes = columns ? gb->gridbox.max_wids : gb->gridbox.max_hgts ;
+      weights = columns ? gb->gridbox.max_weightx : gb->gridbox.max_weighty ;
+      end = min(idx - n, nt) ;
+      memmove(sizes + idx, sizes + end, (nt - end) * sizeof(int)) ;
+      memmove(weights + idx, weights + end, (nt - end) * sizeof(int)) ;
+      if( columns )
+	gb->gridbox.nx = nt - (end - idx) ;
+      else
+	gb->gridbox.ny = nt - (end - idx) ;
+    }
+    return True ;
+}
+
+
+void
+GridboxInsertRows(w, row, n)
+    Widget	w ;
+    int		row, n ;
+{
+    if( n > 0 ) {
+      LockWidget(w) ;
+      shiftTracks((GridboxWidget)w, False, row, n) ;
+      UnlockWidget(w) ;
+    }
+}
+
+
+void
+GridboxDeleteRows(w, row, n)
+    Widget	w ;
+    int		row, n ;
+{
+    if( n > 0 ) {
+      LockWidget(w) ;
+      shiftTracks((GridboxWidget)w, False, row, -n) ;
+      UnlockWidget(w) ;
+    }
+}
+
+
+void
+GridboxInsertColumns(w, column, n)
+    Widget	w ;
+    int		column, n ;
+{
+    if( n > 0 ) {
+      LockWidget(w) ;
+      shiftTracks((GridboxWidget)w, True, column, n) ;
+      UnlockWidget(w) ;
+    }
+}
+
+
+void
+GridboxDeleteColumns(w, column, n)
+    Widget	w ;
+    int		column, n ;
+{
+    if( n > 0 ) {
+      LockWidget(w) ;
+      shiftTracks((GridboxWidget)w, True, column, -n) ;
+      UnlockWidget(w) ;
+    }
+}
+
+
+	/* DORMANCY */
+
+	/* While nobody can see the Gridbox, there's no point in laying
+	 * it out.  Changes are noted in dormant_dirty and needs_layout,
+	 * and caught up on in one go when it becomes visible again, which
+	 * X reports with a VisibilityNotify event.  Unmapping an ancestor
+	 * with XUnmapWindow or XtUnmapWidget is not reported, so only
+	 * Xt's view of the ancestors is checked.
+	 */
+
+static	Bool
+dormant(gb)
+    GridboxWidget	gb ;
+{
+    return XtIsRealized((Widget)gb) &&
+	(gb->gridbox.obscured || withdrawn(gb)) ;
+}
+
+
+	/* Dormant, and not merely obscured:  unmapped, or an ancestor
+	 * is unmanaged or not mapped when managed.
+	 */
+
+static	Bool
+withdrawn(gb)
+    GridboxWidget	gb ;
+{
+    Widget	w ;
+
+    if( !XtIsRealized((Widget)gb) )
+      return False ;
+    if( gb->gridbox.unmapped )
+      return True ;
+    for(w = (Widget)gb; w != NULL && !XtIsShell(w); w = XtParent(w))
+      if( !XtIsManaged(w) || !w->core.mapped_when_managed )
+	return True ;
+    return False ;
+}
+
+
+	/* Bring the layout up to date after a dormant spell. */
+
+static	void
+catchUp(gb)
+    GridboxWidget	gb ;
+{
+    if( gb->gridbox.dormant_dirty ) {
+      gb->gridbox.dormant_dirty = False ;
+      getPreferredSizes(gb, False) ;
+      computeWidHgtInfo(gb) ;
+      fitToGrid(gb) ;
+    }
+    else if( gb->gridbox.needs_layout )
+      XtClass((Widget)gb)->core_class.resize((Widget)gb) ;
+}
+
+
+/* ARGSUSED */
+static	void
+visibilityChange(w, client_data, event, cont)
+    Widget	w ;
+    XtPointer	client_data ;
+    XEvent	*event ;
+    Boolean	*cont ;
+{
+    GridboxWidget	gb = (GridboxWidget)client_data ;
+
+    switch( event->type ) {
+      case VisibilityNotify:
+	gb->gridbox.obscured =
+		event->xvisibility.state == VisibilityFullyObscured ;
+	break ;
+      case MapNotify:
+	gb->gridbox.unmapped = False ;
+	break ;
+      case UnmapNotify:
+	gb->gridbox.unmapped = True ;
+	return ;
+      default:
+	return ;
+    }
+
+    if( !dormant(gb) )
+      catchUp(gb) ;
+}
+
+
+
+	/* WINDOWLESS CHILDREN */
+
+	/* RectObj children (and Motif gadgets) have no windows, so
+	 * Gridbox draws them from its own expose method.  Managed
+	 * windowless children are kept in 'gadgets', sorted by row, so
+	 * that only the rows in the exposed area need be looked at.
+	 */
+
+static	void
+redisplayGadgets(gb, event, region)
+    GridboxWidget	gb ;
+    XEvent		*event ;
+    Region		region ;
+{
+    Region	exposed = region, clip, cell ;
+    XRectangle	box ;
+    Widget	child ;
+    GridboxConstraints	gc ;
+    int		r0, r1 ;
+    int		i, lo, hi, mid ;
+
+    if( gb->gridbox.gadget_generation != gb->gridbox.generation )
+      collectGadgets(gb) ;
+    if( gb->gridbox.ngadgets <= 0 )
+      return ;
+
+    if( exposed == NULL ) {
+      box.x = event->xexpose.x ;
+      box.y = event->xexpose.y ;
+      box.width = event->xexpose.width ;
+      box.height = event->xexpose.height ;
+      exposed = XCreateRegion() ;
+      XUnionRectWithRegion(&box, exposed, exposed) ;
+    }
+    XClipBox(exposed, &box) ;
+
+    /* Exposed rows; a gadget may start a few rows above the first */
+    r0 = rowAt(gb, box.y) - (gb->gridbox.gadget_span - 1) ;
+    r1 = rowAt(gb, box.y + box.height - 1) ;
+
+    for(lo=0, hi=gb->gridbox.ngadgets; lo < hi; )
+    {
+      mid = (lo+hi)/2 ;
+      gc = (GridboxConstraints) gb->gridbox.gadgets[mid]->core.constraints ;
+      if( gc->gridbox.gridy < r0 )
+	lo = mid+1 ;
+      else
+	hi = mid ;
+    }
+
+    clip = XCreateRegion() ;
+    for(i=lo; i < gb->gridbox.ngadgets; ++i)
+    {
+      child = gb->gridbox.gadgets[i] ;
+      gc = (GridboxConstraints) child->core.constraints ;
+      if( gc->gridbox.gridy > r1 )
+	break ;
+      if( !XtIsManaged(child) || gc->gridbox.hidden ||
+	  XtClass(child)->core_class.expose == NULL )
+	continue ;
+
+      box.x = child->core.x ;
+      box.y = child->core.y ;
+      box.width = child->core.width + 2*child->core.border_width ;
+      box.height = child->core.height + 2*child->core.border_width ;
+      if( XRectInRegion(exposed, box.x, box.y, box.width, box.height)
+		== RectangleOut )
+	continue ;
+
+      cell = XCreateRegion() ;
+      XUnionRectWithRegion(&box, cell, cell) ;
+      XIntersectRegion(cell, exposed, clip) ;
+      XDestroyRegion(cell) ;
+      (*XtClass(child)->core_class.expose)(child, event, clip) ;
+    }
+
+    XDestroyRegion(clip) ;
+    if( exposed != region )
+      XDestroyRegion(exposed) ;
+}
+
+
+	/* Rebuild the list of windowless children. */
+
+static	void
+collectGadgets(gb)
+    GridboxWidget	gb ;
+{
+    Widget	*childP ;
+    int		i, n ;
+    GridboxConstraints	gc ;
+
+    if( gb->gridbox.gadgets_alloc < gb->composite.num_children ) {
+      gb->gridbox.gadgets_alloc = gb->composite.num_children ;
+      gb->gridbox.gadgets = (Widget *) XtRealloc((char *)gb->gridbox.gadgets,
+	gb->gridbox.gadgets_alloc * sizeof(Widget)) ;
+    }
+
+    gb->gridbox.gadget_span = 1 ;
+    for( i=0, n=0, childP = gb->composite.children;
+	 i < gb->composite.num_children ;
+	 ++i, ++childP )
+      if( XtIsManaged(*childP) && !XtIsWidget(*childP) )
+      {
+	gc = (GridboxConstraints) (*childP)->core.constraints ;
+	gb->gridbox.gadgets[n++] = *childP ;
+	gb->gridbox.gadget_span =
+		max(gb->gridbox.gadget_span, gc->gridbox.gridHeight) ;
+      }
+
+    if( n > 1 )
+      qsort(gb->gridbox.gadgets, n, sizeof(Widget), gadgetCompare) ;
+    gb->gridbox.ngadgets = n ;
+    gb->gridbox.gadget_generation = gb->gridbox.generation ;
+}
+
+
+static	int
+gadgetCompare(a, b)
+    const void	*a, *b ;
+{
+    GridboxConstraints	ga = (GridboxConstraints)(*(Widget *)a)->core.constraints ;
+    GridboxConstraints	gb = (GridboxConstraints)(*(Widget *)b)->core.constraints ;
+
+    return ga->gridbox.gridy - gb->gridbox.gridy ;
+}
+
+
+	/* Return the row containing pixel row y. */
+
+static	int
+rowAt(gb, y)
+    GridboxWidget	gb ;
+    int			y ;
+{
+    int		i, pos ;
+
+    if( gb->gridbox.ny <= 0 )
+      return 0 ;
+
+    if( gb->gridbox.tracks_stale )
+      layout(gb, gb->core.width, gb->core.height) ;
+
+    if( gb->gridbox.uniform ) {
+      for(i=0; i < gb->gridbox.ny-1; ++i)
+	if( RowEdge(gb, i+1) > y )
+	  break ;
+    }
+    else
+      for(i=0, pos=0; i < gb->gridbox.ny-1; ++i)
+	if( (pos += gb->gridbox.hgts[i]) > y )
+	  break ;
+
+    return max(0, min(i, gb->gridbox.ny-1)) ;
+}
+
+
+
+	/* SIZE GROUPS */
+
+	/* A size group shares column widths (or row heights) among
+	 * several Gridboxes.  Each member contributes its own preferred
+	 * sizes, which are kept in group_wids or group_hgts; the group
+	 * keeps the largest contribution for each column, and every member
+	 * uses that in place of its own.  When a member's contribution
+	 * changes, only the columns it affects are recomputed, and only the
+	 * members with those columns are laid out again.  That is done from
+	 * a work proc, since the member whose contribution changed may be in
+	 * the middle of its own geometry negotiations.
+	 */
+
+GridboxGroup
+GridboxCreateGroup()
+{
+    GridboxGroup	group = XtNew(GridboxGroupRec) ;
+
+    group->members = NULL ;
+    group->nmembers = 0 ;
+    group->sizes = NULL ;
+    group->nsizes = 0 ;
+    group->proc = (XtWorkProcId)0 ;
+    return group ;
+}
+
+
+void
+GridboxDestroyGroup(group)
+    GridboxGroup	group ;
+{
+    Widget		w ;
+
+    while( group->nmembers > 0 ) {
+      w = (Widget)group->members[0].gb ;
+      LockWidget(w) ;
+      groupJoin(group->members[0].gb, group->members[0].columns, NULL) ;
+      UnlockWidget(w) ;
+    }
+    if( group->proc != (XtWorkProcId)0 )
+      XtRemoveWorkProc(group->proc) ;
+    XtFree((char *)group->sizes) ;
+    XtFree((char *)group) ;
+}
+
+
+void
+GridboxSetColumnGroup(w, group)
+    Widget		w ;
+    GridboxGroup	group ;
+{
+    LockWidget(w) ;
+    groupJoin((GridboxWidget)w, True, group) ;
+    UnlockWidget(w) ;
+}
+
+
+void
+GridboxSetRowGroup(w, group)
+    Widget		w ;
+    GridboxGroup	group ;
+{
+    LockWidget(w) ;
+    groupJoin((GridboxWidget)w, False, group) ;
+    UnlockWidget(w) ;
+}
+
+
+	/* Leave the current column (row) group, if any, and join the
+	 * given one, if any.
+	 */
+
+static	void
+groupJoin(gb, columns, group)
+    GridboxWidget	gb ;
+    Bool		columns ;
+    GridboxGroup	group ;
+{
+    GridboxGroup	old = columns ? gb->gridbox.colgroup : gb->gridbox.rowgroup ;
+    int			**rown = columns ?
+			  &gb->gridbox.group_wids : &gb->gridbox.group_hgts ;
+    int			*rnown = columns ?
+			  &gb->gridbox.group_nx : &gb->gridbox.group_ny ;
+    int			i ;
+
+    if( old == group )
+      return ;
+
+    /* The group's work proc lays out every member from one application
+     * context, so all members must share it.
+     */
+    if( group != NULL && group->nmembers > 0 &&
+	XtWidgetToApplicationContext((Widget)group->members[0].gb) !=
+	  XtWidgetToApplicationContext((Widget)gb) )
+    {
+      XtAppWarning(XtWidgetToApplicationContext((Widget)gb),
+	  "Gridbox: group members must share an application context") ;
+      return ;
+    }
+
+    if( old != NULL )
+    {
+      /* withdraw our contribution, then ourselves */
+      groupContribute(old, gb, columns, NULL, 0) ;
+      for(i=0; i < old->nmembers; ++i)
+	if( old->members[i].gb == gb && old->members[i].columns == columns ) {
+	  old->members[i] = old->members[--old->nmembers] ;
+	  break ;
+	}
+      XtFree((char *)*rown) ;
+      *rown = NULL ;
+      *rnown = 0 ;
+    }
+
+    if( columns )
+      gb->gridbox.colgroup = group ;
+    else
+      gb->gridbox.rowgroup = group ;
+
+    if( group != NULL ) {
+      group->members = (GridboxGroupMember *) XtRealloc(
+	(char *)group->members,
+	(group->nmembers+1) * sizeof(GridboxGroupMember)) ;
+      group->members[group->nmembers].gb = gb ;
+      group->members[group->nmembers].columns = columns ;
+      ++group->nmembers ;
+    }
+
+    /* Recompute our own sizes, which contributes them to the group */
+    if( gb->gridbox.max_wids != NULL && !gb->core.being_destroyed )
+    {
+      computeWidHgtMax(gb) ;
+      if( XtIsRealized((Widget)gb) )
+	fitToGrid(gb) ;
+      else
+	gb->gridbox.needs_layout = True ;
+    }
+}
+
+
+	/* Called from computeTotals().  Contribute our column widths (row
+	 * heights) to the group, and replace them with the group's.
+	 */
+
+static	void
+groupPublish(gb, columns)
+    GridboxWidget	gb ;
+    Bool		columns ;
+{
+    GridboxGroup	group = columns ? gb->gridbox.colgroup : gb->gridbox.rowgroup ;
+    int			*sizes = columns ? gb->gridbox.max_wids : gb->gridbox.max_hgts ;
+    int			n = columns ? gb->gridbox.nx : gb->gridbox.ny ;
+    int			i ;
+
+    groupContribute(group, gb, columns, sizes, n) ;
+
+    for(i=0; i < n; ++i)
+      sizes[i] = group->sizes[i] ;
+    if( columns )
+      clampTracks(gb->gridbox.col_tracks, gb->gridbox.ncol_tracks, sizes, n) ;
+    else
+      clampTracks(gb->gridbox.row_tracks, gb->gridbox.nrow_tracks, sizes, n) ;
+}
+
+
+	/* Replace this member's contribution with sizes[0..n-1], update
+	 * the group's sizes, and schedule the other members which are
+	 * affected to be laid out again.
+	 */
+
+static	void
+groupContribute(group, gb, columns, sizes, n)
+    GridboxGroup	group ;
+    GridboxWidget	gb ;
+    Bool		columns ;
+    int			*sizes ;
+    int			n ;
+{
+    int			**rown = columns ?
+			  &gb->gridbox.group_wids : &gb->gridbox.group_hgts ;
+    int			*rnown = columns ?
+			  &gb->gridbox.group_nx : &gb->gridbox.group_ny ;
+    int			*own ;
+    int			nown = *rnown ;
+    int			i, j, lo = -1 ;
+    int			old, new, size ;
+    GridboxGroupMember	*m ;
+
+    if( n > group->nsizes ) {
+      group->sizes = (int *) XtRealloc((char *)group->sizes,
+	n * sizeof(int)) ;
+      memset(group->sizes + group->nsizes, 0,
+	(n - group->nsizes) * sizeof(int)) ;
+      group->nsizes = n ;
+    }
+    if( n > nown ) {
+      *rown = (int *) XtRealloc((char *)*rown, n * sizeof(int)) ;
+      memset(*rown + nown, 0, (n - nown) * sizeof(int)) ;
+    }
+    own = *rown ;
+
+    for(i=0; i < max(n, nown); ++i)
+    {
+      old = own[i] ;
+      new = i < n ? sizes[i] : 0 ;
+      own[i] = new ;
+      if( old == new )
+	continue ;
+
+      if( new > group->sizes[i] )
+	size = new ;
+      else if( old == group->sizes[i] )
+      {
+	/* we were the largest; find the new largest */
+	for(size=new, j=0, m = group->members; j < group->nmembers; ++j, ++m)
+	  if( m->gb != gb || m->columns != columns ) {
+	    int *o = m->columns ? m->gb->gridbox.group_wids :
+					m->gb->gridbox.group_hgts ;
+	    int no = m->columns ? m->gb->gridbox.group_nx :
+				  m->gb->gridbox.group_ny ;
+	    if( i < no && o[i] > size )
+	      size = o[i] ;
+	  }
+      }
+      else
+	continue ;
+
+      if( size != group->sizes[i] ) {
+	group->sizes[i] = size ;
+	if( lo < 0 )
+	  lo = i ;
+      }
+    }
+    *rnown = max(n, nown) ;
+
+    if( lo < 0 )
+      return ;
+
+    /* Bring the other affected members up to date.  Groups don't
+     * apply to homogeneous members, which may have become so since
+     * they joined.
+     */
+    for(j=0, m = group->members; j < group->nmembers; ++j, ++m)
+      if( (m->gb != gb || m->columns != columns) &&
+	  m->gb->gridbox.max_wids != NULL && !m->gb->gridbox.homogeneous &&
+	  (m->columns ? m->gb->gridbox.nx : m->gb->gridbox.ny) > lo )
+      {
+	n = m->columns ? m->gb->gridbox.nx : m->gb->gridbox.ny ;
+	sizes = m->columns ? m->gb->gridbox.max_wids : m->gb->gridbox.max_hgts ;
+	for(i=lo; i < n && i < group->nsizes; ++i)
+	  sizes[i] = group->sizes[i] ;
+	if( m->columns )
+	  clampTracks(m->gb->gridbox.col_tracks, m->gb->gridbox.ncol_tracks,
+	    sizes, n) ;
+	else
+	  clampTracks(m->gb->gridbox.row_tracks, m->gb->gridbox.nrow_tracks,
+	    sizes, n) ;
+	computeSums(m->gb) ;
+	++m->gb->gridbox.generation ;
+	m->gb->gridbox.group_dirty = True ;
+	if( group->proc == (XtWorkProcId)0 )
+	  group->proc = XtAppAddWorkProc(
+	    XtWidgetToApplicationContext((Widget)m->gb),
+	    groupLayout, (XtPointer)group) ;
+      }
+}
+
+
+	/* Work proc; lay out the members whose sizes were changed by
+	 * another member.
+	 */
+
+static	Boolean
+groupLayout(client_data)
+    XtPointer	client_data ;
+{
+    GridboxGroup	group = (GridboxGroup)client_data ;
+    GridboxWidget	gb ;
+    int			i ;
+
+    group->proc = (XtWorkProcId)0 ;
+    for(i=0; i < group->nmembers; ++i)
+    {
+      gb = group->members[i].gb ;
+      if( !gb->gridbox.group_dirty )
+	continue ;
+      gb->gridbox.group_dirty = False ;
+      if( XtIsRealized((Widget)gb) )
+	fitToGrid(gb) ;
+      else
+	gb->gridbox.needs_layout = True ;
+    }
+    return True ;
+}
+
+
+	/* Put our own sizes back in place of the group's, for the
+	 * functions which update them incrementally.
+	 */
+
+static	void
+groupRestore(gb)
+    GridboxWidget	gb ;
+{
+    if( gb->gridbox.colgroup != NULL && gb->gridbox.max_wids != NULL )
+      memcpy(gb->gridbox.max_wids, gb->gridbox.group_wids,
+	min(gb->gridbox.nx, gb->gridbox.group_nx) * sizeof(int)) ;
+    if( gb->gridbox.rowgroup != NULL && gb->gridbox.max_hgts != NULL )
+      memcpy(gb->gridbox.max_hgts, gb->gridbox.group_hgts,
+	min(gb->gridbox.ny, gb->gridbox.group_ny) * sizeof(int)) ;
+}
+
+
+
+	/* LAYOUT SNAPSHOTS */
+
+	/* When publishLayout is set, an immutable copy of the layout is
+	 * published after every layout for the use of other threads.
+	 * Readers take a reference with GridboxGetLayout() and drop it
+	 * with GridboxReleaseLayout(); whoever drops the last reference
+	 * frees the snapshot.  The widget itself holds one reference to
+	 * the current snapshot.
+	 *
+	 * The one race is between a reader loading the snapshot pointer
+	 * and taking its reference, during which the Xt thread might
+	 * replace the snapshot and drop the last reference to it.  So
+	 * readers count themselves in snap_readers while they do that,
+	 * and the Xt thread keeps replaced snapshots on snap_retired until
+	 * it sees no reader there.  Nobody waits, except GridboxDestroy.
+	 */
+
+#if defined(__GNUC__) && defined(__ATOMIC_SEQ_CST)
+#define	LoadLayout(p)		__atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define	SwapLayout(p,v)		__atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+#define	AtomicAdd(p,n)		__atomic_add_fetch((p), (n), __ATOMIC_SEQ_CST)
+#else
+	/* No atomic operations; fall back on the Xt process lock, which
+	 * requires that the application call XtToolkitThreadInitialize().
+	 */
+#ifdef	__STDC__
+static	GridboxLayout *swapLayout(GridboxLayout **, GridboxLayout *, Bool) ;
+static	int	atomicAdd(int *, int) ;
+#else
+static	GridboxLayout *swapLayout() ;
+static	int	atomicAdd() ;
+#endif
+#define	LoadLayout(p)		swapLayout((p), NULL, False)
+#define	SwapLayout(p,v)		swapLayout((p), (v), True)
+#define	AtomicAdd(p,n)		atomicAdd((p), (n))
+
+static	GridboxLayout *
+swapLayout(p, snap, store)
+    GridboxLayout	**p ;
+    GridboxLayout	*snap ;
+    Bool		store ;
+{
+    GridboxLayout	*old ;
+
+    XtProcessLock() ;
+    old = *p ;
+    if( store )
+      *p = snap ;
+    XtProcessUnlock() ;
+    return old ;
+}
+
+static	int
+atomicAdd(p, n)
+    int		*p ;
+    int		n ;
+{
+    int		rval ;
+
+    XtProcessLock() ;
+    rval = *p += n ;
+    XtProcessUnlock() ;
+    return rval ;
+}
+#endif
+
+
+	/* Take a reference to the current snapshot.  May be called
+	 * from any thread.
+	 */
+
+GridboxLayout *
+GridboxGetLayout(w)
+    Widget	w ;
+{
+    GridboxWidget	gb = (GridboxWidget)w ;
+    GridboxLayout	*snap ;
+
+    (void) AtomicAdd(&gb->gridbox.snap_readers, 1) ;
+    if( (snap = LoadLayout(&gb->gridbox.snapshot)) != NULL )
+      (void) AtomicAdd(&snap->refcount, 1) ;
+    (void) AtomicAdd(&gb->gridbox.snap_readers, -1) ;
+    return snap ;
+}
+
+
+void
+GridboxReleaseLayout(snap)
+    GridboxLayout	*snap ;
+{
+    if( snap != NULL && AtomicAdd(&snap->refcount, -1) == 0 )
+      XtFree((char *)snap) ;
+}
+
+
+	/* Copy the current layout into a new snapshot.  Everything
+	 * goes into one block, pointers first for alignment.  If the
+	 * last layout was done from the slopes, the rows and columns
+	 * are worked out the same way rather than by a full layout().
+	 */
+
+static	GridboxLayout *
+buildLayout(gb)
+    GridboxWidget	gb ;
+{
+    WidgetList	children = gb->composite.children;
+    int		num_children = gb->composite.num_children;
+    int		nx = gb->gridbox.nx ;
+    int		ny = gb->gridbox.ny ;
+    int		i, nc, pos ;
+    Bool	linear ;
+    GridboxLayout	*snap ;
+    XRectangle	*rect ;
+    Widget	child ;
+
+    for(i=0, nc=0; i < num_children; ++i)
+      if( XtIsManaged(children[i]) )
+	++nc ;
+
+    linear = gb->gridbox.tracks_stale && gb->gridbox.linear_ok &&
+	gb->gridbox.slope_generation == gb->gridbox.generation &&
+	gb->core.width >= gb->gridbox.total_wid &&
+	gb->core.height >= gb->gridbox.total_hgt ;
+    if( gb->gridbox.tracks_stale && !linear )
+      layout(gb, gb->core.width, gb->core.height) ;
+
+    snap = (GridboxLayout *) XtMalloc(sizeof(GridboxLayout) +
+	nc * (sizeof(Widget) + sizeof(XRectangle)) +
+	(nx + ny) * 2 * sizeof(int)) ;
+    snap->refcount = 1 ;
+    snap->next = NULL ;
+    snap->serial = ++gb->gridbox.snap_serial ;
+    snap->nx = nx ;
+    snap->ny = ny ;
+    snap->nchildren = nc ;
+    snap->children = (Widget *) (snap+1) ;
+    snap->rects = (XRectangle *) (snap->children + nc) ;
+    snap->col_x = (int *) (snap->rects + nc) ;
+    snap->col_width = snap->col_x + nx ;
+    snap->row_y = snap->col_width + nx ;
+    snap->row_height = snap->row_y + ny ;
+
+    if( linear ) {
+      linearTracks(nx, gb->gridbox.max_wids, gb->gridbox.max_weightx,
+	gb->core.width - gb->gridbox.total_wid, gb->gridbox.total_weightx,
+	snap->col_x, snap->col_width) ;
+      linearTracks(ny, gb->gridbox.max_hgts, gb->gridbox.max_weighty,
+	gb->core.height - gb->gridbox.total_hgt, gb->gridbox.total_weighty,
+	snap->row_y, snap->row_height) ;
+    }
+    else {
+      for(i=0, pos=0; i < nx; ++i) {
+	snap->col_x[i] = pos ;
+	snap->col_width[i] = gb->gridbox.uniform ?
+		ColumnEdge(gb, i+1) - ColumnEdge(gb, i) : gb->gridbox.wids[i] ;
+	pos += snap->col_width[i] ;
+      }
+      for(i=0, pos=0; i < ny; ++i) {
+	snap->row_y[i] = pos ;
+	snap->row_height[i] = gb->gridbox.uniform ?
+		RowEdge(gb, i+1) - RowEdge(gb, i) : gb->gridbox.hgts[i] ;
+	pos += snap->row_height[i] ;
+      }
+    }
+
+    for(i=0, rect=snap->rects; i < num_children; ++i)
+      if( XtIsManaged(child = children[i]) )
+      {
+	snap->children[rect - snap->rects] = child ;
+	rect->x = child->core.x ;
+	rect->y = child->core.y ;
+	rect->width = child->core.width ;
+	rect->height = child->core.height ;
+	++rect ;
+      }
+
+    return snap ;
+}
+
+
+	/* Positions and sizes of the rows or columns, as linearLayout()
+	 * places them:  each edge is at its unweighted position plus
+	 * the share of the excess for the weight preceding it.
+	 */
+
+static	void
+linearTracks(n, max_sizes, weights, excess, weight, pos, sizes)
+    int		n ;
+    int		*max_sizes ;
+    int		*weights ;
+    int		excess, weight ;
+    int		*pos, *sizes ;		/* RETURN */
+{
+    int		i ;
+    int		base, cweight, edge, next ;
+
+    for(i=0, base=0, cweight=0, edge=0; i < n; ++i)
+    {
+      base += max_sizes[i] ;
+      cweight += weights[i] ;
+      next = base + (weight > 0 ? cweight*excess/weight : 0) ;
+      pos[i] = edge ;
+      sizes[i] = next - edge ;
+      edge = next ;
+    }
+}
+
+
+	/* Replace the current snapshot with a new one, or with none if
+	 * 'on' is not set.  The old one is retired, to be released
+	 * when no reader can be about to take a reference to it.
+	 */
+
+static	void
+publishLayout(gb, on)
+    GridboxWidget	gb ;
+    Bool		on ;
+{
+    GridboxLayout	*old ;
+
+    old = SwapLayout(&gb->gridbox.snapshot, on ? buildLayout(gb) : NULL) ;
+    if( old != NULL ) {
+      old->next = gb->gridbox.snap_retired ;
+      gb->gridbox.snap_retired = old ;
+    }
+    reapLayouts(gb, False) ;
+}
+
+
+	/* Drop our references to retired snapshots, if no reader is
+	 * between loading the snapshot pointer and taking a reference.
+	 * If 'wait' is set, wait for such readers; it takes them only
+	 * a few instructions.  Otherwise, if there are any, try again
+	 * when the application is idle, so a retired snapshot is freed
+	 * as soon as its last reader lets go of it, not at the next
+	 * layout.
+	 */
+
+static	void
+reapLayouts(gb, wait)
+    GridboxWidget	gb ;
+    Bool		wait ;
+{
+    GridboxLayout	*snap ;
+
+    if( gb->gridbox.snap_retired == NULL )
+      return ;
+
+    while( AtomicAdd(&gb->gridbox.snap_readers, 0) != 0 )
+      if( !wait ) {
+	if( gb->gridbox.reap_proc == (XtWorkProcId)0 )
+	  gb->gridbox.reap_proc = XtAppAddWorkProc(
+		XtWidgetToApplicationContext((Widget)gb),
+		reapLater, (XtPointer)gb) ;
+	return ;
+      }
+
+    while( (snap = gb->gridbox.snap_retired) != NULL ) {
+      gb->gridbox.snap_retired = snap->next ;
+      GridboxReleaseLayout(snap) ;
+    }
+}
+
+
+	/* Work proc, see reapLayouts(). */
+
+static	Boolean
+reapLater(client_data)
+    XtPointer	client_data ;
+{
+    GridboxWidget	gb = (GridboxWidget)client_data ;
+
+    gb->gridbox.reap_proc = (XtWorkProcId)0 ;
+    reapLayouts(gb, False) ;
+    return True ;
+}
+
+
+
+void
+GridboxGetStats(w, stats)
+    Widget		w ;
+    GridboxStats	*stats ;
+{
+    LockWidget(w) ;
+    *stats = ((GridboxWidget)w)->gridbox.stats ;
+    UnlockWidget(w) ;
+}
+
+
+
+
+	/* LAYOUT CACHE FILE */
+
+	/* File format, in native byte order:
+	 *	magic, hash, number of children	(3 x CARD32)
+	 *	one CacheRecord per managed child, in order
+	 */
+
+#define	CACHE_MAGIC	0x47425831	/* "GBX1" */
+
+typedef	struct {
+    short		gridx, gridy ;
+    unsigned short	width, height ;
+} CacheRecord ;
+
+
+	/* FNV-1a hash */
+
+static	unsigned long
+hashBytes(hash, ptr, len)
+    unsigned long	hash ;
+    const void		*ptr ;
+    int			len ;
+{
+    const unsigned char	*p = ptr ;
+
+    while( --len >= 0 ) {
+      hash ^= *p++ ;
+      hash = (hash * 16777619) & 0xffffffff ;
+    }
+    return hash ;
+}
+
+#define	hashString(hash, str)	\
+	((str) != NULL ? hashBytes(hash, str, strlen(str)+1) : (hash))
+#define	hashInt(hash, i)	\
+	(tmp = (i), hashBytes(hash, &tmp, sizeof(tmp)))
+
+
+	/* Hash everything that could affect the children's preferred
+	 * sizes:  their names, classes, constraints and initial sizes
+	 * (which reflect their fonts and labels), our own resources
+	 * and the server resource database.  Return the number of
+	 * managed children as well.
+	 */
+
+static	unsigned long
+layoutHash(gb, rnchild)
+    GridboxWidget	gb ;
+    int			*rnchild ;
+{
+    unsigned long	hash = 2166136261UL ;
+    Widget		*childP ;
+    int			i, n = 0 ;
+    long		tmp ;
+    GridboxConstraints	gc ;
+    Display		*dpy = XtDisplay((Widget)gb) ;
+
+    hash = hashString(hash, XResourceManagerString(dpy)) ;
+    hash = hashString(hash, gb->gridbox.columnSpec) ;
+    hash = hashString(hash, gb->gridbox.rowSpec) ;
+    hash = hashInt(hash, gb->gridbox.defaultDistance) ;
+    hash = hashInt(hash, gb->gridbox.homogeneous) ;
+
+    for( i=0, childP = gb->composite.children;
+	 i < gb->composite.num_children ;
+	 ++i, ++childP )
+      if( XtIsManaged(*childP) )
+      {
+	gc = (GridboxConstraints) (*childP)->core.constraints ;
+	hash = hashString(hash, XtName(*childP)) ;
+	hash = hashString(hash, XtClass(*childP)->core_class.class_name) ;
+	hash = hashInt(hash, gc->gridbox.gridx) ;
+	hash = hashInt(hash, gc->gridbox.gridy) ;
+	hash = hashInt(hash, gc->gridbox.gridWidth) ;
+	hash = hashInt(hash, gc->gridbox.gridHeight) ;
+	hash = hashInt(hash, gc->gridbox.margin) ;
+	hash = hashInt(hash, gc->gridbox.allowResize) ;
+	hash = hashInt(hash, (*childP)->core.width) ;
+	hash = hashInt(hash, (*childP)->core.height) ;
+	hash = hashInt(hash, (*childP)->core.border_width) ;
+	++n ;
+      }
+
+    *rnchild = n ;
+    return hash ;
+}
+
+
+	/* Read preferred sizes from the layout cache file.  Return
+	 * False if the file doesn't exist or doesn't match.
+	 */
+
+static	Bool
+loadPrefs(gb)
+    GridboxWidget	gb ;
+{
+    FILE		*ifile ;
+    CARD32		header[3] ;
+    CacheRecord		*records, *rec ;
+    Widget		*childP ;
+    int			i, n = gb->gridbox.saved_nchild ;
+    GridboxConstraints	gc ;
+
+    if( n <= 0 || (ifile = fopen(gb->gridbox.layoutCacheFile, "rb")) == NULL )
+      return False ;
+
+    if( fread(header, sizeof(header), 1, ifile) != 1  ||
+	header[0] != CACHE_MAGIC  ||
+	header[1] != gb->gridbox.saved_hash  ||
+	header[2] != n )
+    {
+      fclose(ifile) ;
+      return False ;
+    }
+
+    records = XTCALLOC(n, CacheRecord) ;
+    if( fread(records, sizeof(CacheRecord), n, ifile) != n ) {
+      fclose(ifile) ;
+      XtFree((char *)records) ;
+      return False ;
+    }
+    fclose(ifile) ;
+
+    for( i=0, rec = records, childP = gb->composite.children;
+	 i < gb->composite.num_children ;
+	 ++i, ++childP )
+      if( XtIsManaged(*childP) )
+      {
+	gc = (GridboxConstraints) (*childP)->core.constraints ;
+	gc->gridbox.gridx = rec->gridx ;
+	gc->gridbox.gridy = rec->gridy ;
+	gc->gridbox.prefWidth = rec->width ;
+	gc->gridbox.prefHeight = rec->height ;
+	gc->gridbox.prefs_valid = True ;
+	++rec ;
+      }
+
+    XtFree((char *)records) ;
+    ++gb->gridbox.generation ;
+    return True ;
+}
+
+
+	/* Write the current preferred sizes to the layout cache file.
+	 * Only done if the same children are managed as when the hash
+	 * was computed.
+	 */
+
+static	void
+savePrefs(gb)
+    GridboxWidget	gb ;
+{
+    FILE		*ofile ;
+    CARD32		header[3] ;
+    CacheRecord		*records, *rec ;
+    Widget		*childP ;
+    int			i, n = 0 ;
+    char		*tmpname ;
+    GridboxConstraints	gc ;
+
+    for( i=0, childP = gb->composite.children;
+	 i < gb->composite.num_children ;
+	 ++i, ++childP )
+      if( XtIsManaged(*childP) )
+	++n ;
+
+    if( n <= 0 || n != gb->gridbox.saved_nchild )
+      return ;
+
+    records = XTCALLOC(n, CacheRecord) ;
+    for( i=0, rec = records, childP = gb->composite.children;
+	 i < gb->composite.num_children ;
+	 ++i, ++childP )
+      if( XtIsManaged(*childP) )
+      {
+	gc = (GridboxConstraints) (*childP)->core.constraints ;
+	rec->gridx = gc->gridbox.gridx ;
+	rec->gridy = gc->gridbox.gridy ;
+	rec->width = ToDimension(gc->gridbox.prefWidth) ;
+	rec->height = ToDimension(gc->gridbox.prefHeight) ;
+	++rec ;
+      }
+
+    header[0] = CACHE_MAGIC ;
+    header[1] = gb->gridbox.saved_hash ;
+    header[2] = n ;
+
+    /* write to a temporary file first, so a reader never sees
+     * a partial file.
+     */
+    tmpname = XtMalloc(strlen(gb->gridbox.layoutCacheFile) + 5) ;
+    sprintf(tmpname, "%s.tmp", gb->gridbox.layoutCacheFile) ;
+    if( (ofile = fopen(tmpname, "wb")) != NULL )
+    {
+      if( fwrite(header, sizeof(header), 1, ofile) == 1  &&
+	  fwrite(records, sizeof(CacheRecord), n, ofile) == n  &&
+	  fclose(ofile) == 0 )
+	(void) rename(tmpname, gb->gridbox.layoutCacheFile) ;
+      else
+	(void) remove(tmpname) ;
+    }
+
+    XtFree(tmpname) ;
+    XtFree((char *)records) ;
+}
+
+
+	/* Work proc.  If the preferred sizes came from the layout cache
+	 * file, query the children now and lay out again if anything was
+	 * different.  Then update the file.
+	 */
+
+static	Boolean
+validatePrefs(client_data)
+    XtPointer	client_data ;
+{
+    GridboxWidget	gb = (GridboxWidget)client_data ;
+    int			*prefs ;
+    Widget		*childP ;
+    int			i, n ;
+    Bool		changed = !gb->gridbox.saved_loaded ;
+    GridboxConstraints	gc ;
+
+    gb->gridbox.saved_proc = (XtWorkProcId)0 ;
+    gb->gridbox.saved_state = SAVED_DONE ;
+
+    if( gb->gridbox.saved_loaded )
+    {
+      prefs = XTCALLOC(2 * max(gb->composite.num_children,1), int) ;
+      for( i=n=0, childP = gb->composite.children;
+	   i < gb->composite.num_children ;
+	   ++i, ++childP )
+	if( XtIsManaged(*childP) ) {
+	  gc = (GridboxConstraints) (*childP)->core.constraints ;
+	  prefs[n++] = gc->gridbox.prefWidth ;
+	  prefs[n++] = gc->gridbox.prefHeight ;
+	}
+
+      getPreferredSizes(gb, True) ;
+
+      for( i=n=0, childP = gb->composite.children;
+	   i < gb->composite.num_children ;
+	   ++i, ++childP )
+	if( XtIsManaged(*childP) ) {
+	  gc = (GridboxConstraints) (*childP)->core.constraints ;
+	  if( prefs[n++] != gc->gridbox.prefWidth ||
+	      prefs[n++] != gc->gridbox.prefHeight )
+	    changed = True ;
+	}
+      XtFree((char *)prefs) ;
+
+      if( changed )
+	relayout(gb) ;
+    }
+
+    if( changed )
+      savePrefs(gb) ;
+
+    return True ;
+}
+
+
+
+
+	/* CHILD DESCRIPTION FILES */
+
+	/* Creating children one at a time from the resource database costs
+	 * a string conversion of every constraint, and a change_managed
+	 * for each.  A child description file holds the constraints ready
+	 * to use; the file is mapped, each child is created with its
+	 * constraints passed as arguments, already converted, and the
+	 * children are managed together.  Xt still builds each child's
+	 * database search list and looks up its other resources; only the
+	 * conversions and the change_managed calls are saved.  The file
+	 * format is described in GridboxP.h.
+	 */
+
+static	int
+loadChildren(w, file, classes, num_classes)
+    Widget	w ;
+    String	file ;
+    WidgetClass	*classes ;
+    Cardinal	num_classes ;
+{
+    int			fd ;
+    struct stat		st ;
+    char		*map ;
+    GridboxChildHeader	*header ;
+    CARD32		*names ;
+    GridboxChildRecord	*rec ;
+    char		*strings ;
+    WidgetClass		*wclasses ;
+    Widget		*children ;
+    Arg			args[12] ;
+    Cardinal		na ;
+    int			i, j, n ;
+
+    if( (fd = open(file, O_RDONLY)) < 0 )
+      return -1 ;
+    if( fstat(fd, &st) < 0 || st.st_size < sizeof(GridboxChildHeader) ||
+	(map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0))
+		== (char *)MAP_FAILED )
+    {
+      close(fd) ;
+      return -1 ;
+    }
+    close(fd) ;
+
+    /* Check that everything lies within the file, and that the string
+     * table ends with a nul, so every name does.
+     */
+    header = (GridboxChildHeader *) map ;
+    names = (CARD32 *) (header+1) ;
+    rec = (GridboxChildRecord *) (names + header->nclasses) ;
+    strings = (char *) (rec + header->nchildren) ;
+    if( header->magic != GBC_MAGIC ||
+	header->nclasses > st.st_size / sizeof(CARD32) ||
+	header->nchildren > st.st_size / sizeof(GridboxChildRecord) ||
+	header->strings == 0 ||
+	strings + header->strings != map + st.st_size ||
+	strings[header->strings-1] != '\0' )
+    {
+      munmap(map, st.st_size) ;
+      XtAppWarning(XtWidgetToApplicationContext(w),
+	  "Gridbox: not a child description file") ;
+      return -1 ;
+    }
+
+    wclasses = XTCALLOC(header->nclasses+1, WidgetClass) ;
+    for(i=0; i < header->nclasses; ++i)
+      if( names[i] < header->strings ) {
+	for(j=0; j < num_classes; ++j)
+	  if( strcmp(classes[j]->core_class.class_name, strings+names[i]) == 0 )
+	    break ;
+	if( j < num_classes )
+	  wclasses[i] = classes[j] ;
+	else
+	  XtAppWarning(XtWidgetToApplicationContext(w),
+	      "Gridbox: child description names an unknown class") ;
+      }
+
+    children = (Widget *) XtMalloc((header->nchildren+1) * sizeof(Widget)) ;
+    for(i=0, n=0; i < header->nchildren; ++i, ++rec)
+    {
+      if( rec->name >= header->strings || rec->wclass >= header->nclasses ||
+	  wclasses[rec->wclass] == NULL )
+	continue ;
+
+      na = 0 ;
+      XtSetArg(args[na], XtNgridx, rec->gridx) ; ++na ;
+      XtSetArg(args[na], XtNgridy, rec->gridy) ; ++na ;
+      XtSetArg(args[na], XtNgridWidth, rec->gridWidth) ; ++na ;
+      XtSetArg(args[na], XtNgridHeight, rec->gridHeight) ; ++na ;
+      XtSetArg(args[na], XtNfill, rec->fill) ; ++na ;
+      XtSetArg(args[na], XtNgravity, rec->gravity) ; ++na ;
+      XtSetArg(args[na], XtNweightx, rec->weightx) ; ++na ;
+      XtSetArg(args[na], XtNweighty, rec->weighty) ; ++na ;
+      XtSetArg(args[na], XtNmargin, rec->margin) ; ++na ;
+      XtSetArg(args[na], XtNallowResize, rec->allowResize) ; ++na ;
+      if( rec->width != 0 ) {
+	XtSetArg(args[na], XtNwidth, rec->width) ; ++na ;
+      }
+      if( rec->height != 0 ) {
+	XtSetArg(args[na], XtNheight, rec->height) ; ++na ;
+      }
+      children[n++] = XtCreateWidget(strings + rec->name,
+			wclasses[rec->wclass], w, args, na) ;
+    }
+
+    munmap(map, st.st_size) ;
+
+    XtManageChildren(children, n) ;
+
+    XtFree((char *)children) ;
+    XtFree((char *)wclasses) ;
+    return n ;
+}
+
+
+int
+GridboxLoadChildren(w, file, classes, num_classes)
+    Widget	w ;
+    String	file ;
+    WidgetClass	*classes ;
+    Cardinal	num_classes ;
+{
+    int		n ;
+
+    LockWidget(w) ;
+    n = loadChildren(w, file, classes, num_classes) ;
+    UnlockWidget(w) ;
+    return n ;
+}
+
+
+	/* Append a string to a growing string table; return its offset. */
+
+static	int
+addString(strings, nstrings, alloc, str)
+    char	**strings ;
+    int		*nstrings, *alloc ;
+    String	str ;
+{
+    int		len = strlen(str) + 1 ;
+    int		offset = *nstrings ;
+
+    if( offset + len > *alloc ) {
+      *alloc = max(2 * *alloc, offset + len + 1024) ;
+      *strings = XtRealloc(*strings, *alloc) ;
+    }
+    memcpy(*strings + offset, str, len) ;
+    *nstrings += len ;
+    return offset ;
+}
+
+
+int
+GridboxSaveChildren(w, file)
+    Widget	w ;
+    String	file ;
+{
+    GridboxWidget	gb = (GridboxWidget)w ;
+    Widget		*childP ;
+    GridboxConstraints	gc ;
+    GridboxChildHeader	header ;
+    GridboxChildRecord	*records, *rec ;
+    WidgetClass		*wclasses ;
+    CARD32		*names ;
+    char		*strings ;
+    int			nstrings = 0, strings_alloc = 0 ;
+    int			nclasses = 0 ;
+    int			i, j, n ;
+    FILE		*ofile ;
+    int			result = -1 ;
+
+    LockWidget(w) ;
+
+    strings = NULL ;
+    n = gb->composite.num_children ;
+    records = XTCALLOC(n+1, GridboxChildRecord) ;
+    wclasses = XTCALLOC(n+1, WidgetClass) ;
+    names = XTCALLOC(n+1, CARD32) ;
+
+    for( i=0, rec = records, childP = gb->composite.children;
+	 i < gb->composite.num_children ;
+	 ++i, ++childP )
+      if( XtIsManaged(*childP) )
+      {
+	gc = (GridboxConstraints) (*childP)->core.constraints ;
+
+	for(j=0; j < nclasses; ++j)
+	  if( wclasses[j] == XtClass(*childP) )
+	    break ;
+	if( j == nclasses ) {
+	  wclasses[nclasses] = XtClass(*childP) ;
+	  names[nclasses++] = addString(&strings, &nstrings, &strings_alloc,
+				XtClass(*childP)->core_class.class_name) ;
+	}
+
+	rec->name = addString(&strings, &nstrings, &strings_alloc,
+				XtName(*childP)) ;
+	rec->wclass = j ;
+	rec->gridx = gc->gridbox.gridx ;
+	rec->gridy = gc->gridbox.gridy ;
+	rec->gridWidth = gc->gridbox.gridWidth ;
+	rec->gridHeight = gc->gridbox.gridHeight ;
+	rec->fill = gc->gridbox.fill ;
+	rec->gravity = gc->gridbox.gravity ;
+	rec->weightx = gc->gridbox.weightx ;
+	rec->weighty = gc->gridbox.weighty ;
+	rec->margin = gc->gridbox.margin ;
+	rec->allowResize = gc->gridbox.allowResize ;
+	++rec ;
+      }
+
+    UnlockWidget(w) ;
+
+    header.magic = GBC_MAGIC ;
+    header.nclasses = nclasses ;
+    header.nchildren = rec - records ;
+    header.strings = nstrings ;
+
+    if( nstrings > 0 && (ofile = fopen(file, "wb")) != NULL )
+    {
+      if( fwrite(&header, sizeof(header), 1, ofile) == 1  &&
+	  fwrite(names, sizeof(CARD32), nclasses, ofile) == nclasses  &&
+	  fwrite(records, sizeof(GridboxChildRecord), header.nchildren, ofile)
+		== header.nchildren  &&
+	  fwrite(strings, 1, nstrings, ofile) == nstrings )
+	result = 0 ;
+      if( fclose(ofile) != 0 )
+	result = -1 ;
+    }
+
+    XtFree(strings) ;
+    XtFree((char *)names) ;
+    XtFree((char *)wclasses) ;
+    XtFree((char *)records) ;
+    return result ;
+}
+
+
+
+
+	/* TRACING */
+
+	/* Trace files are shared by all the Gridboxes which name them,
+	 * so that the interactions between nested Gridboxes are captured
+	 * in order.
+	 */
+
+typedef	struct _GridboxTrace {
+    struct _GridboxTrace *next ;
+    String		name ;
+    FILE		*file ;
+    int			refcount ;
+    int			ngridbox ;	/* ids handed out so far */
+    struct timeval	start ;
+} GridboxTrace ;
+
+static	GridboxTrace	*traces = NULL ;
+
+
+static	void
+traceOpen(gb)
+    GridboxWidget	gb ;
+{
+    GridboxTrace	*trace ;
+    Widget		parent = XtParent((Widget)gb) ;
+    CARD32		magic = GBT_MAGIC ;
+    int			args[6] ;
+
+    XtProcessLock() ;
+    for(trace = traces; trace != NULL; trace = trace->next)
+      if( strcmp(trace->name, gb->gridbox.traceFile) == 0 )
+	break ;
+
+    if( trace == NULL )
+    {
+      FILE	*file = fopen(gb->gridbox.traceFile, "wb") ;
+      if( file == NULL ) {
+	XtProcessUnlock() ;
+	XtAppWarning(XtWidgetToApplicationContext((Widget)gb),
+	    "Gridbox: cannot open trace file") ;
+	return ;
+      }
+      (void) fwrite(&magic, sizeof(magic), 1, file) ;
+
+      trace = XtNew(GridboxTrace) ;
+      trace->name = XtNewString(gb->gridbox.traceFile) ;
+      trace->file = file ;
+      trace->refcount = 0 ;
+      trace->ngridbox = 0 ;
+      gettimeofday(&trace->start, NULL) ;
+      trace->next = traces ;
+      traces = trace ;
+    }
+
+    ++trace->refcount ;
+    gb->gridbox.trace = trace ;
+    gb->gridbox.trace_id = trace->ngridbox++ ;
+    XtProcessUnlock() ;
+
+    if( XtIsSubclass(parent, gridboxWidgetClass) &&
+	((GridboxWidget)parent)->gridbox.trace == trace )
+    {
+      args[0] = ((GridboxWidget)parent)->gridbox.trace_id ;
+      args[1] = ((GridboxWidget)parent)->composite.num_children ;
+    }
+    else
+      args[0] = args[1] = GBT_NONE ;
+    args[2] = gb->core.width ;
+    args[3] = gb->core.height ;
+    args[4] = gb->gridbox.defaultDistance ;
+    args[5] = gb->gridbox.homogeneous ;
+    traceRecord(gb, GBT_CREATE, NULL, args, 6) ;
+}
+
+
+static	void
+traceClose(gb)
+    GridboxWidget	gb ;
+{
+    GridboxTrace	*trace = gb->gridbox.trace, **ptr ;
+
+    traceRecord(gb, GBT_DESTROY, NULL, NULL, 0) ;
+    gb->gridbox.trace = NULL ;
+
+    XtProcessLock() ;
+    if( --trace->refcount <= 0 )
+    {
+      for(ptr = &traces; *ptr != trace; ptr = &(*ptr)->next) ;
+      *ptr = trace->next ;
+      fclose(trace->file) ;
+      XtFree(trace->name) ;
+      XtFree((char *)trace) ;
+    }
+    XtProcessUnlock() ;
+}
+
+
+static	unsigned long
+traceTime(gb)
+    GridboxWidget	gb ;
+{
+    struct timeval	now ;
+    GridboxTrace	*trace = gb->gridbox.trace ;
+
+    gettimeofday(&now, NULL) ;
+    return (now.tv_sec - trace->start.tv_sec) * 1000000 +
+	   (now.tv_usec - trace->start.tv_usec) ;
+}
+
+
+	/* Write one record.  Records made while another traced call is
+	 * in progress (e.g. a nested Gridbox's request to this one during
+	 * a resize) are marked with their depth, so that the replayer
+	 * can tell which events it must drive itself and which will
+	 * follow from others.
+	 */
+
+static	void
+traceRecord(gb, type, child, args, nargs)
+    GridboxWidget	gb ;
+    int			type ;
+    Widget		child ;
+    int			*args ;
+    int			nargs ;
+{
+    GridboxTraceRecord	rec ;
+    INT32		iargs[16] ;
+    int			i ;
+
+    rec.type = type ;
+    rec.nargs = nargs ;
+    rec.gridbox = gb->gridbox.trace_id ;
+    rec.child = GBT_NONE ;
+    rec.depth = traceDepth ;
+    rec.time = traceTime(gb) ;
+
+    if( child != NULL )
+      for(i=0; i < gb->composite.num_children; ++i)
+	if( gb->composite.children[i] == child ) {
+	  rec.child = i ;
+	  break ;
+	}
+
+    for(i=0; i < nargs; ++i)
+      iargs[i] = args[i] ;
+
+    XtProcessLock() ;
+    (void) fwrite(&rec, sizeof(rec), 1, gb->gridbox.trace->file) ;
+    (void) fwrite(iargs, sizeof(INT32), nargs, gb->gridbox.trace->file) ;
+    XtProcessUnlock() ;
+}
+
+
+	/* Record the constraints and preferred size of one child. */
+
+static	void
+traceChild(gb, type, child)
+    GridboxWidget	gb ;
+    int			type ;
+    Widget		child ;
+{
+    GridboxConstraints	gc = (GridboxConstraints) child->core.constraints ;
+    int			args[13] ;
+
+    args[0] = gc->gridbox.gridx ;
+    args[1] = gc->gridbox.gridy ;
+    args[2] = gc->gridbox.gridWidth ;
+    args[3] = gc->gridbox.gridHeight ;
+    args[4] = gc->gridbox.fill ;
+    args[5] = gc->gridbox.gravity ;
+    args[6] = gc->gridbox.weightx ;
+    args[7] = gc->gridbox.weighty ;
+    args[8] = gc->gridbox.margin ;
+    args[9] = gc->gridbox.allowResize ;
+    args[10] = gc->gridbox.prefWidth ;
+    args[11] = gc->gridbox.prefHeight ;
+    args[12] = child->core.border_width ;
+    traceRecord(gb, type, child, args, 13) ;
 }
@@ -25,6 +25,15 @@
  border		     BorderColor	Pixel		XtDefaultForeground
  borderWidth	     BorderWidth	Dimension	1
  defaultDistance     Thickness		int		4
+ homogeneous	     Homogeneous	Boolean		False
+ columnSpec	     TrackSpec		String		NULL
+ rowSpec	     TrackSpec		String		NULL
+ layoutCacheFile     File		String		NULL
+ traceFile	     File		String		NULL
+ layoutCallback	     Callback		Callback	NULL
+ publishLayout	     PublishLayout	Boolean		False
+ preserveContents    PreserveContents	Boolean		False
+ batchConfigure	     BatchConfigure	Boolean		False
  destroyCallback     Callback		Pointer		NULL
  width		     Width		Dimension	computed at realize
  height		     Height		Dimension	computed at realize
@@ -34,6 +43,27 @@
 
 
   defaultDistance	specifies the default margin around child widgets.
+  homogeneous		all rows are made the same height and all columns
+			the same width.
+  columnSpec, rowSpec	declare sizes and weights of individual columns
+			and rows.  A list of entries separated by spaces,
+			one per column or row, starting with 0.  Each
+			entry is "*" (no declaration), "N" (fixed size),
+			"N-M", "N-" or "-M" (minimum and/or maximum size),
+			optionally followed by ":W" (weight).
+			e.g. "32 * 40-200:1"
+  layoutCacheFile	file in which to save children's preferred sizes
+			between runs of the application.
+  traceFile		file to which all geometry management events are
+			logged, for later playback by gridboxreplay.
+  layoutCallback	called after a layout which moved or resized any
+			children; call_data is a pointer to a
+			GridboxLayoutCallbackStruct.
+  publishLayout		keep a copy of the layout for other threads, see
+			GridboxGetLayout().
+  preserveContents	give children NorthWest bit gravity, so that
+			resizing them doesn't expose their contents.
+  batchConfigure	unmap the children which move while moving several.
 
   All other resources are the same as for Constraint.
 
@@ -96,6 +126,38 @@
 #define	XtCGravity	"Gravity"
 #endif
 
+#ifndef	XtNhomogeneous
+#define	XtNhomogeneous	"homogeneous"
+#define	XtCHomogeneous	"Homogeneous"
+#endif
+
+#ifndef	XtNcolumnSpec
+#define	XtNcolumnSpec	"columnSpec"
+#define	XtNrowSpec	"rowSpec"
+#define	XtCTrackSpec	"TrackSpec"
+#endif
+
+#ifndef	XtNlayoutCacheFile
+#define	XtNlayoutCacheFile	"layoutCacheFile"
+#define	XtNtraceFile		"traceFile"
+#endif
+
+#ifndef	XtNlayoutCallback
+#define	XtNlayoutCallback	"layoutCallback"
+#endif
+
+#ifndef	XtNpublishLayout
+#define	XtNpublishLayout	"publishLayout"
+#define	XtCPublishLayout	"PublishLayout"
+#endif
+
+#ifndef	XtNpreserveContents
+#define	XtNpreserveContents	"preserveContents"
+#define	XtCPreserveContents	"PreserveContents"
+#define	XtNbatchConfigure	"batchConfigure"
+#define	XtCBatchConfigure	"BatchConfigure"
+#endif
+
 #ifndef	XtNallowResize
 #define	XtNallowResize	"allowResize"
 #define	XtCAllowResize	"AllowResize"
@@ -111,6 +173,57 @@ typedef	unsigned int	FillType ;
 #define	GRIDBOX_NEXT	-1
 #define	GRIDBOX_SAME	-2
 
+#define	GRIDBOX_DEFAULT	-1	/* track weight taken from children */
+
+/* Performance counters, see GridboxGetStats() */
+
+typedef	struct {
+    unsigned long	cache_hits ;	/* layouts found in the layout cache */
+    unsigned long	cache_misses ;	/* layouts computed */
+    unsigned long	linear_layouts ; /* of those, done from slopes */
+    unsigned long	exposes ;	/* Expose events, Gridbox & children */
+    unsigned long	fast_grants ;	/* requests granted without layout */
+} GridboxStats ;
+
+typedef struct _GridboxGroupRec *GridboxGroup ;
+
+/* call_data for layoutCallback.  Only children whose geometry changed
+ * are listed.  The column and row ranges are those occupied by the
+ * listed children.
+ */
+
+typedef	struct {
+    Widget		child ;
+    XRectangle		old_geometry ;
+    XRectangle		new_geometry ;
+} GridboxChange ;
+
+typedef	struct {
+    GridboxChange	*changes ;
+    int			nchanges ;
+    int			first_column, last_column ;
+    int			first_row, last_row ;
+} GridboxLayoutCallbackStruct ;
+
+/* Read-only copy of a layout, see GridboxGetLayout().  Cell edges are
+ * relative to the Gridbox; rects[i] is the geometry of children[i],
+ * which lists the managed children.  The widgets may only be used for
+ * comparison outside the Xt thread.
+ */
+
+typedef	struct _GridboxLayout {
+    unsigned long	serial ;	/* increases with each layout */
+    int			nx, ny ;
+    int			*col_x, *row_y ;
+    int			*col_width, *row_height ;
+    int			nchildren ;
+    Widget		*children ;
+    XRectangle		*rects ;
+    /* private */
+    int			refcount ;
+    struct _GridboxLayout *next ;
+} GridboxLayout ;
+
 typedef	struct _GridboxClassRec	*GridboxWidgetClass ;
 typedef	struct _GridboxRec	*GridboxWidget ;
 
@@ -118,6 +231,177 @@ extern	WidgetClass	gridboxWidgetClass ;
 
 _XFUNCPROTOBEGIN
 
+/* Declare the size limits and weight of one column or row.  minsize
+ * and maxsize of 0 mean no limit; minsize == maxsize means fixed
+ * size.  weight of GRIDBOX_DEFAULT means use the children's weights.
+ */
+
+extern	void	GridboxSetColumn(
+#if NeedFunctionPrototypes
+    Widget	/* w */,
+    int		/* column */,
+    int		/* minsize */,
+    int		/* maxsize */,
+    int		/* weight */
+#endif
+) ;
+
+extern	void	GridboxSetRow(
+#if NeedFunctionPrototypes
+    Widget	/* w */,
+    int		/* row */,
+    int		/* minsize */,
+    int		/* maxsize */,
+    int		/* weight */
+#endif
+) ;
+
+/* Insert or delete n rows or columns at the given position.  Children
+ * are moved down or right (up or left) to make room, spanning children
+ * grow (shrink), and children entirely within deleted rows or columns
+ * are unmanaged.  Row and column declarations move with the children.
+ */
+
+extern	void	GridboxInsertRows(
+#if NeedFunctionPrototypes
+    Widget	/* w */,
+    int		/* row */,
+    int		/* n */
+#endif
+) ;
+
+extern	void	GridboxDeleteRows(
+#if NeedFunctionPrototypes
+    Widget	/* w */,
+    int		/* row */,
+    int		/* n */
+#endif
+) ;
+
+extern	void	GridboxInsertColumns(
+#if NeedFunctionPrototypes
+    Widget	/* w */,
+    int		/* column */,
+    int		/* n */
+#endif
+) ;
+
+extern	void	GridboxDeleteColumns(
+#if NeedFunctionPrototypes
+    Widget	/* w */,
+    int		/* column */,
+    int		/* n */
+#endif
+) ;
+
+/* Collapse (True) or expand (False) a row or column.  A collapsed row or
+ * column has zero size, and children entirely within collapsed rows or
+ * columns are unmapped.  This applies to homogeneous Gridboxes too; the
+ * remaining rows and columns keep their common size.
+ */
+
+extern	void	GridboxCollapseColumn(
+#if NeedFunctionPrototypes
+    Widget	/* w */,
+    int		/* column */,
+    Bool	/* collapse */
+#endif
+) ;
+
+extern	void	GridboxCollapseRow(
+#if NeedFunctionPrototypes
+    Widget	/* w */,
+    int		/* row */,
+    Bool	/* collapse */
+#endif
+) ;
+
+/* Size groups make several Gridboxes use the same column widths (or row
+ * heights), namely the largest that any of them needs.  A Gridbox may be
+ * in one column group and one row group; pass NULL to leave a group.
+ * Groups are ignored by homogeneous Gridboxes.
+ */
+
+extern	GridboxGroup	GridboxCreateGroup(
+#if NeedFunctionPrototypes
+    void
+#endif
+) ;
+
+extern	void	GridboxDestroyGroup(
+#if NeedFunctionPrototypes
+    GridboxGroup	/* group */
+#endif
+) ;
+
+extern	void	GridboxSetColumnGroup(
+#if NeedFunctionPrototypes
+    Widget		/* w */,
+    GridboxGroup	/* group */
+#endif
+) ;
+
+extern	void	GridboxSetRowGroup(
+#if NeedFunctionPrototypes
+    Widget		/* w */,
+    GridboxGroup	/* group */
+#endif
+) ;
+
+/* Return a reference to the most recent layout, or NULL if there is
+ * none or publishLayout is not set.  The layout never changes; release
+ * it with GridboxReleaseLayout() when done.  These two may be called
+ * from any thread, but the widget must outlive the call.
+ */
+
+extern	GridboxLayout	*GridboxGetLayout(
+#if NeedFunctionPrototypes
+    Widget		/* w */
+#endif
+) ;
+
+extern	void	GridboxReleaseLayout(
+#if NeedFunctionPrototypes
+    GridboxLayout *	/* layout */
+#endif
+) ;
+
+/* Create children from a child description file, made by
+ * GridboxSaveChildren() or by a program (see GridboxP.h), and manage
+ * them all at once.  Each child's class is looked up by name in the
+ * given classes.  Returns the number of children created, or -1 if
+ * the file cannot be read.
+ */
+
+extern	int	GridboxLoadChildren(
+#if NeedFunctionPrototypes
+    Widget		/* w */,
+    String		/* file */,
+    WidgetClass *	/* classes */,
+    Cardinal		/* num_classes */
+#endif
+) ;
+
+/* Describe the managed children in a child description file.  Returns
+ * 0, or -1 if the file cannot be written.
+ */
+
+extern	int	GridboxSaveChildren(
+#if NeedFunctionPrototypes
+    Widget		/* w */,
+    String		/* file */
+#endif
+) ;
+
+/* Return the performance counters for this Gridbox. */
+
+extern	void	GridboxGetStats(
+#if NeedFunctionPrototypes
+    Widget		/* w */,
+    GridboxStats *	/* stats_return */
+#endif
+) ;
+
 _XFUNCPROTOEND
  
 #endif /* _Gridbox_h */
@@ -7,6 +7,7 @@
 #define _GridboxP_h
 
 #include <X11/IntrinsicP.h>
+#include <X11/Xmd.h>
 
 #ifdef	USE_MOTIF
 #include <Xm/XmP.h>
@@ -33,6 +34,141 @@ typedef struct _GridboxClassRec {
 extern GridboxClassRec gridboxClassRec;
 
 
+/* Row & column declarations.  A track with minsize == maxsize > 0
+ * is fixed; its size does not depend on its children, and children
+ * which lie entirely within fixed tracks are never queried.
+ * A weight of GRIDBOX_DEFAULT means the maximum weight of the
+ * children in the track.
+ */
+
+typedef struct {
+    int		minsize, maxsize ;	/* 0 = unconstrained */
+    int		weight ;
+    Boolean	collapsed ;		/* size forced to zero */
+} GridboxTrack ;
+
+#define	TrackFixed(t)	((t)->maxsize > 0 && (t)->minsize == (t)->maxsize)
+
+
+/* Layout cache.  GridboxResize() remembers the results of the last
+ * few layouts, keyed by Gridbox size and by the generation of the layout
+ * inputs.  generation is incremented whenever anything that affects
+ * layout changes, which invalidates the whole cache.
+ */
+
+#define	GRIDBOX_CACHE_SIZE	4
+
+typedef struct {
+    Position	x, y ;
+    Dimension	width, height ;
+} GridboxRect ;
+
+typedef struct {			/* see applyRects() */
+    Widget	child ;
+    GridboxRect	*rect ;
+    int		group, key ;		/* configure order */
+} GridboxMove ;
+
+typedef struct {
+    Dimension	width, height ;		/* Gridbox size			*/
+    unsigned long generation ;		/* 0 = empty			*/
+    unsigned long used ;		/* for LRU replacement		*/
+    int		nx, ny, nchild ;
+    int		*wids, *hgts ;
+    int		cell_wid, cell_hgt ;
+    int		cell_xspare, cell_yspare ;
+    GridboxRect	*rects ;		/* managed children, in order	*/
+} GridboxCacheEntry ;
+
+
+/* Size groups, see GridboxSetColumnGroup() */
+
+typedef struct {
+    struct _GridboxRec	*gb ;
+    Bool		columns ;	/* else rows */
+} GridboxGroupMember ;
+
+typedef struct _GridboxGroupRec {
+    GridboxGroupMember	*members ;
+    int			nmembers ;
+    int			*sizes ;	/* largest contribution per track */
+    int			nsizes ;
+    XtWorkProcId	proc ;		/* pending member layouts */
+} GridboxGroupRec ;
+
+
+/* Trace file format.  Gridbox widgets with the traceFile resource
+ * set write a record for every geometry management event.  All Gridboxes
+ * using the same file share it; each is given an id when created.
+ * Each record is a GridboxTraceRecord followed by nargs INT32 arguments,
+ * all in native byte order.  The file begins with GBT_MAGIC.
+ */
+
+#define	GBT_MAGIC	0x47425431	/* "GBT1" */
+
+typedef struct {
+    CARD8	type ;
+    CARD8	nargs ;
+    CARD16	gridbox ;	/* id of Gridbox within this trace	*/
+    CARD16	child ;		/* index in children, or GBT_NONE	*/
+    CARD16	depth ;		/* 0 unless inside another event	*/
+    CARD32	time ;		/* microseconds since trace began	*/
+} GridboxTraceRecord ;
+
+#define	GBT_NONE	0xffff
+
+				/* args:				*/
+#define	GBT_CREATE	1	/* parent id, index in parent, width,
+				 * height, defaultDistance, homogeneous	*/
+#define	GBT_MANAGED	2	/* # managed children, usec; a
+				 * GBT_CHILD record follows for each	*/
+#define	GBT_CHILD	3	/* gridx, gridy, gridWidth, gridHeight,
+				 * fill, gravity, weightx, weighty,
+				 * margin, allowResize, prefWidth,
+				 * prefHeight, border_width		*/
+#define	GBT_REQUEST	4	/* request_mode, x, y, width, height,
+				 * border_width				*/
+#define	GBT_REPLY	5	/* result, width, height, border_width,
+				 * usec					*/
+#define	GBT_QUERY	6	/* request_mode, width, height, result,
+				 * reply width, reply height, usec	*/
+#define	GBT_RESIZE	7	/* width, height, usec			*/
+#define	GBT_CONSTRAINT	8	/* as GBT_CHILD, new values		*/
+#define	GBT_DESTROY	9	/* none					*/
+
+
+
+/* Child description file format, see GridboxLoadChildren().  The file
+ * is a GridboxChildHeader, nclasses CARD32 offsets of class names in
+ * the string table, nchildren GridboxChildRecords, and the string table
+ * of nul-terminated names, all in native byte order.  Programs which
+ * generate descriptions may include this file.
+ */
+
+#define	GBC_MAGIC	0x47424331	/* "GBC1" */
+
+typedef struct {
+    CARD32	magic ;
+    CARD32	nclasses ;
+    CARD32	nchildren ;
+    CARD32	strings ;	/* size of the string table		*/
+} GridboxChildHeader ;
+
+typedef struct {
+    CARD32	name ;		/* offset in the string table		*/
+    INT32	weightx, weighty ;
+    INT32	margin ;	/* < 0 for defaultDistance		*/
+    INT16	gridx, gridy ;	/* may be GRIDBOX_NEXT or GRIDBOX_SAME	*/
+    CARD16	gridWidth, gridHeight ;
+    CARD16	width, height ;	/* 0 to let the child choose		*/
+    CARD16	wclass ;	/* index in the class names		*/
+    CARD8	fill ;
+    CARD8	gravity ;
+    CARD8	allowResize ;
+    CARD8	pad[3] ;
+} GridboxChildRecord ;
+
+
 /* Notes:
  *  nx,ny are the dimensions of the grid, in cells
  *  maxgw, maxgh are the sizes of the largest cells in the grid.
@@ -43,26 +179,101 @@ extern GridboxClassRec gridboxClassRec;
  *
  * wids, hgts are the actual widths and heights of the columns and rows.
  *
+ * nx_alloc, ny_alloc are the allocated lengths of the above arrays, which
+ *	are only reallocated when the grid grows beyond them.
+ *
  * total_wid, total_hgt are the sums of the max_wids, max_hgts arrays
  * total_weightx, total_weighty are the sums of the maximum weights
  *	of the child widgets.
+ *
+ * col_tracks, row_tracks are the row & column declarations from the
+ *	columnSpec and rowSpec resources or GridboxSetColumn() and
+ *	GridboxSetRow().  These are kept across recomputation.
+ *
+ * saved_* describe the layoutCacheFile.  The first time children are
+ *	managed, the preferred sizes are read from the file instead of
+ *	querying the children, if the constraints, child sizes and resource
+ *	database hash to the same value as when the file was written.
+ *	The children are queried later from a work proc, and the file
+ *	rewritten if anything was different.
+ *
+ * uniform is set when every row has the same size and every column has
+ *	the same size, either because homogeneous is set or because the
+ *	children happen to be laid out that way.  In that case, uniform_wid
+ *	and uniform_hgt are the preferred cell sizes, cell_wid and cell_hgt
+ *	are the actual cell sizes before the excess space cell_xspare and
+ *	cell_yspare is shared out (see ColumnEdge()), and wids, hgts are
+ *	not used.
  */
 
 typedef struct _GridboxPart {
     /* resources */
     int		defaultDistance;	/* default distance between children */
+    Boolean	homogeneous ;		/* all rows & columns the same size */
+    String	columnSpec, rowSpec ;	/* row & column declarations */
+    String	layoutCacheFile ;	/* saved preferred sizes */
+    String	traceFile ;		/* geometry event trace */
+    XtCallbackList layoutCallback ;	/* called after each layout */
+    Boolean	publishLayout ;		/* keep a snapshot for other threads */
+    Boolean	preserveContents ;	/* set children's bit gravity */
+    Boolean	batchConfigure ;	/* unmap children while configuring */
 
     /* private state */
     int		nx, ny ;
+    int		nx_alloc, ny_alloc ;	/* allocated size of arrays */
     Dimension	maxgw, maxgh ;
-    Dimension	*max_wids, *max_hgts ;
-    Dimension	*wids, *hgts ;
+    int		*max_wids, *max_hgts ;
+    int		*wids, *hgts ;
     int		*max_weightx, *max_weighty ;
-    Dimension	total_wid, total_hgt ;
+    int		total_wid, total_hgt ;
     int		total_weightx, total_weighty ;
+    GridboxTrack *col_tracks, *row_tracks ;
+    int		ncol_tracks, nrow_tracks ;
+    Bool	uniform ;
+    int		uniform_wid, uniform_hgt ;
+    int		cell_wid, cell_hgt ;
+    int		cell_xspare, cell_yspare ;
     Bool	needs_layout ;
+    unsigned long generation ;		/* of layout inputs */
+    unsigned long slope_generation ;	/* of child slopes, see layout() */
+    Bool	linear_ok ;		/* slopes may be used */
+    Bool	tracks_stale ;		/* wids, hgts need recomputing */
+    unsigned long cache_clock ;
+    GridboxCacheEntry cache[GRIDBOX_CACHE_SIZE] ;
+    GridboxStats stats ;
+    int		saved_state ;		/* of layoutCacheFile, see below */
+    Bool	saved_loaded ;		/* preferred sizes came from file */
+    unsigned long saved_hash ;		/* of the initial constraint set */
+    int		saved_nchild ;
+    XtWorkProcId saved_proc ;
+    int		nhidden ;		/* children hidden by collapse */
+    GridboxGroup colgroup, rowgroup ;	/* shared track sizes */
+    int		*group_wids, *group_hgts ; /* our contributions */
+    int		group_nx, group_ny ;
+    Bool	group_dirty ;		/* group changed our sizes */
+    struct _GridboxTrace *trace ;	/* NULL if not tracing */
+    int		trace_id ;
+    GridboxLayout *snapshot ;		/* current, see GridboxGetLayout() */
+    GridboxLayout *snap_retired ;	/* replaced, not yet released */
+    int		snap_readers ;		/* threads taking a reference */
+    XtWorkProcId reap_proc ;		/* see reapLayouts() */
+    unsigned long snap_serial ;
+    GridboxRect	*scratch_rects ;	/* see linearLayout() */
+    GridboxMove	*moves ;		/* see applyRects() */
+    int		scratch_alloc ;
+    Widget	*gadgets ;		/* windowless children, by row */
+    int		ngadgets, gadgets_alloc ;
+    int		gadget_span ;		/* max gridHeight of gadgets */
+    unsigned long gadget_generation ;
+    Bool	obscured, unmapped ;	/* see dormant() */
+    Bool	dormant_dirty ;		/* track sizes need recomputing */
+    int		negotiating ;		/* nested child geometry requests */
 } GridboxPart;
 
+#define	SAVED_NONE	0	/* layoutCacheFile not examined yet	*/
+#define	SAVED_PENDING	1	/* waiting to validate & write it	*/
+#define	SAVED_DONE	2
+
 typedef struct _GridboxRec {
     CorePart		core;
     CompositePart	composite;
@@ -89,7 +300,16 @@ typedef struct _GridboxConstraintsPart {
 /*
  * Private contstraint resources.
  */
-    Dimension	prefWidth, prefHeight ;	/* what the child wants to be	*/
+    int		prefWidth, prefHeight ;	/* what the child wants to be	*/
+    Bool	prefs_valid ;		/* prefWidth, prefHeight are set */
+    Bool	counted ;		/* included in max_wids etc.	*/
+    Bool	hidden ;		/* unmapped by a collapsed track */
+    Boolean	mapped ;		/* mapped_when_managed if hidden */
+    Bool	bit_gravity ;		/* set by preserveContents	*/
+    int		lin_x0, lin_x1,		/* cell edges at zero excess	*/
+		lin_y0, lin_y1 ;
+    int		lin_wx0, lin_wx1,	/* weight preceding cell edges	*/
+		lin_wy0, lin_wy1 ;
 } GridboxConstraintsPart;
 
 typedef struct _GridboxConstraintsRec {
@@ -0,0 +1,796 @@
+static	char	rcsid[] = "$Id$" ;
+
+/*
+ * gridboxbench - measure the cost of various Gridbox operations.
+ *
+ * usage:  gridboxbench [-n children] [test ...]
+ *
+ * Tests:
+ *	convert		cost of converting the fill, gridx and gridy
+ *			constraint resources from the resource database;
+ *			then of the conversions alone, the first time
+ *			for each of a set of distinct strings (usec/1000
+ *			conversions), and as found in Xt's cache.
+ *	toolbar		one row of children,
+ *	form		two columns of labels and fields,
+ *	table		a table of cells, some spanning two columns,
+ *			each built in Gridbox and in every standard manager
+ *			which can express it:  Athena Box and Form, and,
+ *			when compiled with -DUSE_MOTIF, XmForm and
+ *			XmRowColumn.
+ *	compare		toolbar, form and table.
+ *	load		cost of creating and managing children one at a
+ *			time with constraints from the resource database,
+ *			and of loading the same children from a child
+ *			description file with GridboxLoadChildren().
+ *	expose		a resize drag of a table of labels, with
+ *			batchConfigure off and on:  usec and Expose
+ *			events (GridboxGetStats()) per step.
+ *
+ * With no tests named, all tests are run.  Times are reported in
+ * microseconds per 1000 children, except as noted below.
+ *
+ * The comparison tests report, for each manager:
+ *	create		creating the children, before the manager is
+ *			managed, usec/1000 children.
+ *	layout		managing the manager and popping up its shell,
+ *			until the X server has caught up, usec.
+ *	cold		one step of a resize drag of the shell window,
+ *			through the ConfigureNotify, to a size the
+ *			manager hasn't had before, usec/step.
+ *	warm		going back and forth between the last two sizes
+ *			of that drag, which Gridbox finds in its layout
+ *			cache, usec/step.
+ *	request		one child asking for a new width, usec/request.
+ *	xlayout		X requests issued by the layout phase.
+ *	xresize		X requests issued per cold resize step.
+ * Run these against a server with no window manager (e.g. Xvfb), so
+ * that the shell may be resized freely.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/time.h>
+
+#include <X11/StringDefs.h>
+#include <X11/Intrinsic.h>
+#include <X11/Core.h>
+#include <X11/Shell.h>
+
+#include <X11/Xaw/Box.h>
+#include <X11/Xaw/Form.h>
+#include <X11/Xaw/Label.h>
+
+#ifdef	USE_MOTIF
+#include <Xm/Xm.h>
+#include <Xm/Form.h>
+#include <Xm/RowColumn.h>
+#endif
+
+#include "Gridbox.h"
+
+	/* Xt stuff */
+
+static	XtAppContext	app_ctx ;
+static	Widget		topLevel ;
+static	int		nchildren = 1000 ;
+
+static	String	fillNames[] = {
+	"none", "width", "height", "both", "FillWidth", "Horizontal", "xy",
+} ;
+
+static	String	posNames[] = {
+	"0", "1", "next", "same", "GridNext", "17", "gridboxsame",
+} ;
+
+
+
+	/* Comparison layouts.  Each is a list of cells, at a given column
+	 * and row, spanning one or more columns.
+	 */
+
+#define	TOOLBAR	0
+#define	FORM	1
+#define	TABLE	2
+
+static	String	layoutNames[] = { "toolbar", "form", "table" } ;
+
+typedef	struct {
+	int	x, y ;
+	int	width ;
+} Cell ;
+
+static	Cell	*cells ;
+static	int	ncols, nrows ;
+
+#define	NSTEPS		100	/* resize drag steps */
+#define	NREQUESTS	100	/* child geometry requests */
+
+	/* Each manager supplies the resources which build a layout;
+	 * called with cell == NULL for the manager itself.  left and
+	 * above are the children before and above the cell, or NULL.
+	 */
+
+typedef	struct {
+	String		name ;
+	WidgetClass	*class ;
+	int		layouts ;	/* mask of those it can express */
+	void		(*args)() ;
+} Manager ;
+
+static	void	gridboxArgs(), boxArgs(), formArgs() ;
+#ifdef	USE_MOTIF
+static	void	xmFormArgs(), rowColumnArgs() ;
+#endif
+
+static	Manager	managers[] = {
+	{"gridbox", &gridboxWidgetClass,
+		1<<TOOLBAR | 1<<FORM | 1<<TABLE, gridboxArgs},
+	{"box", &boxWidgetClass, 1<<TOOLBAR, boxArgs},
+	{"form", &formWidgetClass, 1<<TOOLBAR | 1<<FORM | 1<<TABLE, formArgs},
+#ifdef	USE_MOTIF
+	{"xmForm", &xmFormWidgetClass,
+		1<<TOOLBAR | 1<<FORM | 1<<TABLE, xmFormArgs},
+	{"xmRowColumn", &xmRowColumnWidgetClass,
+		1<<TOOLBAR | 1<<FORM, rowColumnArgs},
+#endif
+} ;
+
+
+static	void	ConvertTest() ;
+static	void	LoadTest() ;
+static	void	CompareTest() ;
+static	void	convert() ;
+static	void	ExposeTest() ;
+static	void	compare() ;
+static	void	flush() ;
+static	String	*variants() ;
+
+
+static	double
+now()
+{
+	struct timeval	tv ;
+
+	gettimeofday(&tv, NULL) ;
+	return tv.tv_sec * 1e6 + tv.tv_usec ;
+}
+
+
+static	void
+report(name, usec)
+	char	*name ;
+	double	usec ;
+{
+	printf("%-32s %12.1f usec/1000 children\n",
+	  name, usec * 1000. / nchildren) ;
+}
+
+
+int
+main(int argc, char **argv)
+{
+	int	i ;
+	int	ntests = 0 ;
+
+	topLevel = XtAppInitialize(&app_ctx, "Gridboxbench", NULL,0,
+		&argc,argv, NULL, NULL,0) ;
+
+	for(i=1; i < argc; ++i)
+	{
+	  if( strcmp(argv[i], "-n") == 0 && i+1 < argc )
+	    nchildren = atoi(argv[++i]) ;
+	  else if( strcmp(argv[i], "convert") == 0 ) {
+	    ConvertTest() ;
+	    ++ntests ;
+	  }
+	  else if( strcmp(argv[i], "load") == 0 ) {
+	    LoadTest() ;
+	    ++ntests ;
+	  }
+	  else if( strcmp(argv[i], "toolbar") == 0 ) {
+	    CompareTest(TOOLBAR) ;
+	    ++ntests ;
+	  }
+	  else if( strcmp(argv[i], "form") == 0 ) {
+	    CompareTest(FORM) ;
+	    ++ntests ;
+	  }
+	  else if( strcmp(argv[i], "table") == 0 ) {
+	    CompareTest(TABLE) ;
+	    ++ntests ;
+	  }
+	  else if( strcmp(argv[i], "expose") == 0 ) {
+	    ExposeTest() ;
+	    ++ntests ;
+	  }
+	  else if( strcmp(argv[i], "compare") == 0 ) {
+	    CompareTest(TOOLBAR) ;
+	    CompareTest(FORM) ;
+	    CompareTest(TABLE) ;
+	    ++ntests ;
+	  }
+	  else {
+	    fprintf(stderr,
+	      "usage: %s [-n children] [convert|load|toolbar|form|table|compare|expose]\n",
+	      argv[0]) ;
+	    exit(2) ;
+	  }
+	}
+
+	if( ntests == 0 ) {
+	  ConvertTest() ;
+	  LoadTest() ;
+	  CompareTest(TOOLBAR) ;
+	  CompareTest(FORM) ;
+	  CompareTest(TABLE) ;
+	  ExposeTest() ;
+	}
+
+	exit(0) ;
+	/* NOTREACHED */
+}
+
+
+
+	/* Conversion test.  Put fill, gridx and gridy resources for
+	 * every child into the resource database, then time creating
+	 * the children.  Then time the conversions alone.
+	 */
+
+static	void
+ConvertTest()
+{
+	Widget		gridbox ;
+	XrmDatabase	db = XtDatabase(XtDisplay(topLevel)) ;
+	char		line[128], name[32] ;
+	int		i ;
+	double		t0, t1, t2, t3 ;
+	String		*fills, *positions ;
+	int		nfills, npositions ;
+	FillType	fill ;
+	Position	pos ;
+
+	gridbox = XtCreateWidget("convertGrid",
+		gridboxWidgetClass, topLevel, NULL, 0) ;
+
+	for(i=0; i < nchildren; ++i)
+	{
+	  sprintf(line, "*convertGrid.c%d.fill: %s", i,
+	    fillNames[i % XtNumber(fillNames)]) ;
+	  XrmPutLineResource(&db, line) ;
+	  sprintf(line, "*convertGrid.c%d.gridx: %s", i,
+	    posNames[i % XtNumber(posNames)]) ;
+	  XrmPutLineResource(&db, line) ;
+	  sprintf(line, "*convertGrid.c%d.gridy: %s", i,
+	    posNames[(i/3) % XtNumber(posNames)]) ;
+	  XrmPutLineResource(&db, line) ;
+	}
+
+	t0 = now() ;
+	for(i=0; i < nchildren; ++i) {
+	  sprintf(name, "c%d", i) ;
+	  (void) XtCreateWidget(name, widgetClass, gridbox, NULL, 0) ;
+	}
+	report("create children", now() - t0) ;
+
+	/* The converters are registered with XtCacheAll, so repeated
+	 * strings are only converted once; time distinct strings first.
+	 */
+	fills = variants(fillNames, XtNumber(fillNames), &nfills) ;
+	t0 = now() ;
+	for(i=0; i < nfills; ++i)
+	  convert(gridbox, fills[i], XtRFillType, &fill, sizeof(fill)) ;
+	t1 = now() ;
+	positions = variants(posNames, XtNumber(posNames), &npositions) ;
+	t2 = now() ;
+	for(i=0; i < npositions; ++i)
+	  convert(gridbox, positions[i], XtRGridPosition, &pos, sizeof(pos)) ;
+	t3 = now() ;
+	printf("%-32s %12.1f usec/1000 conversions\n",
+	  "convert fill, first time", (t1 - t0) * 1000. / nfills) ;
+	printf("%-32s %12.1f usec/1000 conversions\n",
+	  "convert gridx/y, first time", (t3 - t2) * 1000. / npositions) ;
+
+	/* Now as the children above convert them, from Xt's cache */
+	t0 = now() ;
+	for(i=0; i < nchildren; ++i)
+	{
+	  convert(gridbox, fillNames[i % XtNumber(fillNames)],
+		XtRFillType, &fill, sizeof(fill)) ;
+	  convert(gridbox, posNames[i % XtNumber(posNames)],
+		XtRGridPosition, &pos, sizeof(pos)) ;
+	  convert(gridbox, posNames[(i/3) % XtNumber(posNames)],
+		XtRGridPosition, &pos, sizeof(pos)) ;
+	}
+	report("convert fill, gridx, gridy, cached", now() - t0) ;
+
+	for(i=0; i < nfills; ++i)
+	  XtFree(fills[i]) ;
+	for(i=0; i < npositions; ++i)
+	  XtFree(positions[i]) ;
+	XtFree((char *)fills) ;
+	XtFree((char *)positions) ;
+
+	XtDestroyWidget(gridbox) ;
+}
+
+
+static	void
+convert(w, str, type, value, size)
+	Widget		w ;
+	String		str, type ;
+	XtPointer	value ;
+	int		size ;
+{
+	XrmValue	from, to ;
+
+	from.addr = str ;
+	from.size = strlen(str) + 1 ;
+	to.addr = value ;
+	to.size = size ;
+	(void) XtConvertAndStore(w, XtRString, &from, type, &to) ;
+}
+
+
+	/* Make up to nchildren distinct spellings of the given names, by
+	 * changing the case of their letters.  Names without letters
+	 * (numbers) are used as they are, and then followed by more
+	 * numbers.
+	 */
+
+static	String *
+variants(names, nnames, rn)
+	String	*names ;
+	int	nnames ;
+	int	*rn ;
+{
+	String	*strs = (String *) XtMalloc(nchildren * sizeof(String)) ;
+	char	*str, *ptr ;
+	int	n = 0, i, v, bit, more ;
+
+	for(v=0, more=1; more && n < nchildren; ++v)
+	{
+	  more = 0 ;
+	  for(i=0; i < nnames && n < nchildren; ++i)
+	  {
+	    str = XtNewString(names[i]) ;
+	    for(ptr = str, bit = 0; *ptr != '\0'; ++ptr)
+	      if( isalpha((unsigned char)*ptr) ) {
+		*ptr = (v & 1<<bit) ? toupper(*ptr) : tolower(*ptr) ;
+		++bit ;
+	      }
+	    if( bit == 0 && v > 0 )
+	      sprintf(str = XtRealloc(str, 16), "%d", 100 + n) ;
+	    else if( bit < 16 && v >= 1<<bit ) {
+	      XtFree(str) ;
+	      continue ;
+	    }
+	    strs[n++] = str ;
+	    more = 1 ;
+	  }
+	}
+
+	*rn = n ;
+	return strs ;
+}
+
+
+
+
+	/* Load test.  Create and manage children one at a time, with their
+	 * constraints in the resource database, as a generated screen
+	 * would.  Save them to a child description file, and time loading
+	 * them from that into an empty Gridbox.
+	 */
+
+static	void
+LoadTest()
+{
+	Widget		gridbox ;
+	XrmDatabase	db = XtDatabase(XtDisplay(topLevel)) ;
+	WidgetClass	classes[1] ;
+	char		line[128], name[32] ;
+	char		*file = "gridboxbench.gbc" ;
+	int		i ;
+	double		t0 ;
+
+	for(i=0; i < nchildren; ++i)
+	{
+	  sprintf(line, "*loadGrid.l%d.gridx: %d", i, i % 50) ;
+	  XrmPutLineResource(&db, line) ;
+	  sprintf(line, "*loadGrid.l%d.gridy: %d", i, i / 50) ;
+	  XrmPutLineResource(&db, line) ;
+	  sprintf(line, "*loadGrid.l%d.fill: %s", i,
+	    fillNames[i % XtNumber(fillNames)]) ;
+	  XrmPutLineResource(&db, line) ;
+	  sprintf(line, "*loadGrid.l%d.weightx: %d", i, i % 3) ;
+	  XrmPutLineResource(&db, line) ;
+	}
+
+	gridbox = XtCreateManagedWidget("loadGrid",
+		gridboxWidgetClass, topLevel, NULL, 0) ;
+	t0 = now() ;
+	for(i=0; i < nchildren; ++i) {
+	  sprintf(name, "l%d", i) ;
+	  (void) XtCreateManagedWidget(name, widgetClass, gridbox, NULL, 0) ;
+	}
+	report("create from resources", now() - t0) ;
+
+	if( GridboxSaveChildren(gridbox, file) != 0 ) {
+	  perror(file) ;
+	  XtDestroyWidget(gridbox) ;
+	  return ;
+	}
+	XtDestroyWidget(gridbox) ;
+
+	/* Load under a different name, so the constraints put into the
+	 * database above don't apply
+	 */
+	gridbox = XtCreateManagedWidget("loadedGrid",
+		gridboxWidgetClass, topLevel, NULL, 0) ;
+	classes[0] = widgetClass ;
+	t0 = now() ;
+	(void) GridboxLoadChildren(gridbox, file, classes, 1) ;
+	report("load from description", now() - t0) ;
+
+	XtDestroyWidget(gridbox) ;
+	(void) remove(file) ;
+}
+
+
+
+	/* Comparison tests.  Lay out the cells, then build the layout
+	 * with each manager that can express it.
+	 */
+
+static	void
+CompareTest(layout)
+	int	layout ;
+{
+	Manager	*m ;
+	int	i, x, y, w ;
+
+	cells = (Cell *) XtMalloc(nchildren * sizeof(Cell)) ;
+
+	switch( layout ) {
+	  case TOOLBAR:
+	    for(i=0; i < nchildren; ++i) {
+	      cells[i].x = i ; cells[i].y = 0 ; cells[i].width = 1 ;
+	    }
+	    ncols = nchildren ;
+	    nrows = 1 ;
+	    break ;
+
+	  case FORM:
+	    for(i=0; i < nchildren; ++i) {
+	      cells[i].x = i%2 ; cells[i].y = i/2 ; cells[i].width = 1 ;
+	    }
+	    ncols = 2 ;
+	    nrows = (nchildren+1)/2 ;
+	    break ;
+
+	  case TABLE:
+	    /* roughly square; every seventh cell spans two columns */
+	    for(ncols=2; ncols*ncols < nchildren; ++ncols) ;
+	    for(i=0, x=0, y=0; i < nchildren; ++i)
+	    {
+	      w = (i%7 == 6 && x+1 < ncols) ? 2 : 1 ;
+	      cells[i].x = x ; cells[i].y = y ; cells[i].width = w ;
+	      if( (x += w) >= ncols ) {
+		x = 0 ;
+		++y ;
+	      }
+	    }
+	    nrows = x > 0 ? y+1 : y ;
+	    break ;
+	}
+
+	printf("\n%s, %d children in %d columns, %d rows:\n",
+	  layoutNames[layout], nchildren, ncols, nrows) ;
+	printf("%-12s %10s %10s %10s %10s %10s %8s %8s\n", "manager",
+	  "create", "layout", "cold", "warm", "request", "xlayout", "xresize") ;
+
+	for(m = managers; m < managers + XtNumber(managers); ++m)
+	  if( m->layouts & 1<<layout )
+	    compare(m, layout) ;
+
+	XtFree((char *)cells) ;
+}
+
+
+static	void
+compare(m, layout)
+	Manager	*m ;
+	int	layout ;
+{
+	Display		*dpy = XtDisplay(topLevel) ;
+	Widget		shell, mgr, left, child ;
+	Widget		*above, *children ;
+	Arg		args[16] ;
+	Cardinal	n ;
+	char		name[32] ;
+	int		i, j ;
+	double		t0, tcreate, tlayout, tresize, twarm, trequest ;
+	unsigned long	r0, rlayout, rresize ;
+	Dimension	width, height, cwidth, cheight ;
+
+	shell = XtCreatePopupShell("compare", topLevelShellWidgetClass,
+		topLevel, NULL, 0) ;
+	n = 0 ;
+	(*m->args)(layout, NULL, NULL, NULL, args, &n) ;
+	mgr = XtCreateWidget(m->name, *m->class, shell, args, n) ;
+
+	/* create */
+	above = (Widget *) XtCalloc(ncols, sizeof(Widget)) ;
+	left = NULL ;
+	t0 = now() ;
+	for(i=0; i < nchildren; ++i)
+	{
+	  if( cells[i].x == 0 )
+	    left = NULL ;
+	  n = 0 ;
+	  (*m->args)(layout, &cells[i], left, above[cells[i].x], args, &n) ;
+	  sprintf(name, "c%d", i) ;
+	  left = XtCreateManagedWidget(name, labelWidgetClass, mgr, args, n) ;
+	  for(j=0; j < cells[i].width; ++j)
+	    above[cells[i].x + j] = left ;
+	}
+	tcreate = now() - t0 ;
+	XtFree((char *)above) ;
+
+	/* first layout */
+	r0 = XNextRequest(dpy) ;
+	t0 = now() ;
+	XtManageChild(mgr) ;
+	XtPopup(shell, XtGrabNone) ;
+	flush() ;
+	tlayout = now() - t0 ;
+	rlayout = XNextRequest(dpy) - r0 ;
+
+	/* resize drag, as the window manager would do it, through sizes
+	 * never seen before; then back and forth between the last two.
+	 */
+	XtVaGetValues(shell, XtNwidth, &width, XtNheight, &height, NULL) ;
+	r0 = XNextRequest(dpy) ;
+	t0 = now() ;
+	for(i=1; i <= NSTEPS; ++i) {
+	  XResizeWindow(dpy, XtWindow(shell), width + 4*i, height + 2*i) ;
+	  flush() ;
+	}
+	tresize = now() - t0 ;
+	rresize = XNextRequest(dpy) - r0 ;
+
+	t0 = now() ;
+	for(i=1; i <= NSTEPS; ++i) {
+	  XResizeWindow(dpy, XtWindow(shell),
+		width + 4*(NSTEPS - i%2), height + 2*(NSTEPS - i%2)) ;
+	  flush() ;
+	}
+	twarm = now() - t0 ;
+
+	/* child requests */
+	XtVaGetValues(mgr, XtNchildren, &children, NULL) ;
+	child = children[nchildren/2] ;
+	XtVaGetValues(child, XtNwidth, &cwidth, XtNheight, &cheight, NULL) ;
+	t0 = now() ;
+	for(i=0; i < NREQUESTS; ++i) {
+	  (void) XtMakeResizeRequest(child, (i&1) ? cwidth : cwidth+8, cheight,
+		NULL, NULL) ;
+	  flush() ;
+	}
+	trequest = now() - t0 ;
+
+	printf("%-12s %10.1f %10.1f %10.1f %10.1f %10.1f %8lu %8lu\n", m->name,
+	  tcreate * 1000. / nchildren, tlayout, tresize / NSTEPS,
+	  twarm / NSTEPS, trequest / NREQUESTS, rlayout, rresize / NSTEPS) ;
+
+	XtDestroyWidget(shell) ;
+	flush() ;
+}
+
+
+	/* Expose test.  Drag-resize a table of labels, every one of which
+	 * moves at each step, with batchConfigure off and on, and count
+	 * the exposures the Gridbox and its children receive.
+	 */
+
+static	void
+ExposeTest()
+{
+	static	Boolean	batch[] = {False, True} ;
+	Display		*dpy = XtDisplay(topLevel) ;
+	Widget		shell, gridbox ;
+	Arg		args[8] ;
+	Cardinal	n ;
+	GridboxStats	s0, s1 ;
+	char		name[32] ;
+	int		i, b, cols ;
+	double		t0, tresize ;
+	Dimension	width, height ;
+
+	for(cols=2; cols*cols < nchildren; ++cols) ;
+	printf("\nexpose, %d children in %d columns:\n", nchildren, cols) ;
+	printf("%-16s %10s %10s\n", "batchConfigure", "resize", "exposes") ;
+
+	for(b=0; b < XtNumber(batch); ++b)
+	{
+	  shell = XtCreatePopupShell("expose", topLevelShellWidgetClass,
+		topLevel, NULL, 0) ;
+	  n = 0 ;
+	  XtSetArg(args[n], XtNbatchConfigure, batch[b]) ; ++n ;
+	  gridbox = XtCreateManagedWidget("exposeGrid", gridboxWidgetClass,
+		shell, args, n) ;
+	  for(i=0; i < nchildren; ++i)
+	  {
+	    n = 0 ;
+	    XtSetArg(args[n], XtNgridx, i % cols) ; ++n ;
+	    XtSetArg(args[n], XtNgridy, i / cols) ; ++n ;
+	    XtSetArg(args[n], XtNweightx, 1) ; ++n ;
+	    XtSetArg(args[n], XtNweighty, 1) ; ++n ;
+	    sprintf(name, "e%d", i) ;
+	    (void) XtCreateManagedWidget(name, labelWidgetClass,
+		gridbox, args, n) ;
+	  }
+	  XtPopup(shell, XtGrabNone) ;
+	  flush() ;
+
+	  XtVaGetValues(shell, XtNwidth, &width, XtNheight, &height, NULL) ;
+	  GridboxGetStats(gridbox, &s0) ;
+	  t0 = now() ;
+	  for(i=1; i <= NSTEPS; ++i) {
+	    XResizeWindow(dpy, XtWindow(shell), width + 4*i, height + 2*i) ;
+	    flush() ;
+	  }
+	  tresize = now() - t0 ;
+	  GridboxGetStats(gridbox, &s1) ;
+
+	  printf("%-16s %10.1f %10.1f\n", batch[b] ? "True" : "False",
+	    tresize / NSTEPS, (double)(s1.exposes - s0.exposes) / NSTEPS) ;
+
+	  XtDestroyWidget(shell) ;
+	  flush() ;
+	}
+}
+
+
+	/* Wait for the server, and handle everything it sent back. */
+
+static	void
+flush()
+{
+	XSync(XtDisplay(topLevel), False) ;
+	while( XtAppPending(app_ctx) )
+	  XtAppProcessEvent(app_ctx, XtIMAll) ;
+}
+
+
+static	void
+gridboxArgs(layout, cell, left, above, args, n)
+	int		layout ;
+	Cell		*cell ;
+	Widget		left, above ;
+	ArgList		args ;
+	Cardinal	*n ;
+{
+	if( cell == NULL )
+	  return ;
+
+	XtSetArg(args[*n], XtNgridx, cell->x) ; ++*n ;
+	XtSetArg(args[*n], XtNgridy, cell->y) ; ++*n ;
+	XtSetArg(args[*n], XtNgridWidth, cell->width) ; ++*n ;
+	if( layout == FORM ) {
+	  XtSetArg(args[*n], XtNfill, cell->x ? FillWidth : FillNone) ; ++*n ;
+	  XtSetArg(args[*n], XtNweightx, cell->x) ; ++*n ;
+	  XtSetArg(args[*n], XtNgravity, WestGravity) ; ++*n ;
+	}
+}
+
+
+	/* Box fills rows left to right; it can only build a toolbar. */
+
+static	void
+boxArgs(layout, cell, left, above, args, n)
+	int		layout ;
+	Cell		*cell ;
+	Widget		left, above ;
+	ArgList		args ;
+	Cardinal	*n ;
+{
+}
+
+
+	/* Form chains each child to its neighbors.  It cannot span
+	 * columns, so a wide cell only pushes the rest of its row over.
+	 */
+
+static	void
+formArgs(layout, cell, left, above, args, n)
+	int		layout ;
+	Cell		*cell ;
+	Widget		left, above ;
+	ArgList		args ;
+	Cardinal	*n ;
+{
+	if( cell == NULL )
+	  return ;
+
+	XtSetArg(args[*n], XtNfromHoriz, left) ; ++*n ;
+	XtSetArg(args[*n], XtNfromVert, above) ; ++*n ;
+	if( layout == FORM && cell->x == 1 ) {
+	  XtSetArg(args[*n], XtNleft, XawChainLeft) ; ++*n ;
+	  XtSetArg(args[*n], XtNright, XawChainRight) ; ++*n ;
+	}
+}
+
+
+#ifdef	USE_MOTIF
+
+	/* XmForm chains the toolbar, and places the cells of the other
+	 * layouts by position, which spans columns.
+	 */
+
+static	void
+xmFormArgs(layout, cell, left, above, args, n)
+	int		layout ;
+	Cell		*cell ;
+	Widget		left, above ;
+	ArgList		args ;
+	Cardinal	*n ;
+{
+	if( cell == NULL ) {
+	  if( layout != TOOLBAR ) {
+	    XtSetArg(args[*n], XmNfractionBase, ncols*nrows) ; ++*n ;
+	  }
+	  return ;
+	}
+
+	if( layout == TOOLBAR ) {
+	  if( left == NULL ) {
+	    XtSetArg(args[*n], XmNleftAttachment, XmATTACH_FORM) ; ++*n ;
+	  }
+	  else {
+	    XtSetArg(args[*n], XmNleftAttachment, XmATTACH_WIDGET) ; ++*n ;
+	    XtSetArg(args[*n], XmNleftWidget, left) ; ++*n ;
+	  }
+	  XtSetArg(args[*n], XmNtopAttachment, XmATTACH_FORM) ; ++*n ;
+	  return ;
+	}
+
+	XtSetArg(args[*n], XmNleftAttachment, XmATTACH_POSITION) ; ++*n ;
+	XtSetArg(args[*n], XmNleftPosition, cell->x * nrows) ; ++*n ;
+	XtSetArg(args[*n], XmNrightAttachment, XmATTACH_POSITION) ; ++*n ;
+	XtSetArg(args[*n], XmNrightPosition, (cell->x + cell->width) * nrows) ;
+	++*n ;
+	XtSetArg(args[*n], XmNtopAttachment, XmATTACH_POSITION) ; ++*n ;
+	XtSetArg(args[*n], XmNtopPosition, cell->y * ncols) ; ++*n ;
+	XtSetArg(args[*n], XmNbottomAttachment, XmATTACH_POSITION) ; ++*n ;
+	XtSetArg(args[*n], XmNbottomPosition, (cell->y + 1) * ncols) ; ++*n ;
+}
+
+
+	/* RowColumn packs children in order, one row per numColumns
+	 * when horizontal.  It cannot span columns.
+	 */
+
+static	void
+rowColumnArgs(layout, cell, left, above, args, n)
+	int		layout ;
+	Cell		*cell ;
+	Widget		left, above ;
+	ArgList		args ;
+	Cardinal	*n ;
+{
+	if( cell != NULL )
+	  return ;
+
+	XtSetArg(args[*n], XmNorientation, XmHORIZONTAL) ; ++*n ;
+	if( layout != TOOLBAR ) {
+	  XtSetArg(args[*n], XmNpacking, XmPACK_COLUMN) ; ++*n ;
+	  XtSetArg(args[*n], XmNnumColumns, nrows) ; ++*n ;
+	}
+}
+
+#endif	/* USE_MOTIF */
@@ -0,0 +1,500 @@
+static	char	rcsid[] = "$Id$" ;
+
+/*
+ * gridboxfuzz - check Gridbox layouts of random grids.
+ *
+ * usage:  gridboxfuzz [-s seed] [-i iterations] [-n children] [-g] [-v]
+ *
+ * Each iteration builds a Gridbox with up to the given number of
+ * children (default 40), at random positions and spans, with random
+ * sizes, borders, margins, weights, fill and gravity.  Some children are
+ * themselves Gridboxes.  It then drives the Gridbox through random shell
+ * resizes, child geometry requests, constraint changes and managing and
+ * unmanaging of children, and after each step checks that:
+ *
+ *	every child lies within its cell;
+ *	a child's geometry request is settled within MAX_ROUNDS requests;
+ *	no step takes longer than MAX_STEP seconds;
+ *	Gridbox issues no warnings (e.g. about non-converging negotiation);
+ *	returning to an earlier size gives the same layout.
+ *
+ * Iteration i uses seed+i, and failures print the iteration's seed, so a
+ * failing grid can be rebuilt alone with "-s seed -i 1 -v".
+ *
+ * With -g, instead time layouts of random grids of 250 to 8000
+ * children, and report any doubling of the number of children which
+ * more than triples the time.
+ *
+ * Run this under Xvfb, with no window manager.  Compile Gridbox.c with
+ * -DDEBUG to check its internal invariants as well.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <sys/time.h>
+
+#include <X11/StringDefs.h>
+#include <X11/Intrinsic.h>
+#include <X11/Core.h>
+#include <X11/Shell.h>
+
+#include "Gridbox.h"
+
+#define	MAX_ROUNDS	4	/* requests to settle a child's request */
+#define	MAX_STEP	1.	/* seconds */
+#define	NSTEPS		40	/* random steps per iteration */
+
+	/* Xt stuff */
+
+static	XtAppContext	app_ctx ;
+static	Widget		topLevel ;
+
+static	int	maxChildren = 40 ;
+static	int	verbose = 0 ;
+static	int	seed ;		/* of the current iteration */
+static	int	failures = 0 ;
+static	int	warnings = 0 ;
+
+
+static	void	iterate() ;
+static	void	growth() ;
+static	Widget	build() ;
+static	void	randomStep() ;
+static	void	requestStep() ;
+static	void	check() ;
+static	void	checkRepeat() ;
+static	void	fail(char *, ...) ;
+static	void	flush() ;
+static	void	warningHandler() ;
+static	int	rnd() ;
+
+
+static	double
+now()
+{
+	struct timeval	tv ;
+
+	gettimeofday(&tv, NULL) ;
+	return tv.tv_sec + tv.tv_usec / 1e6 ;
+}
+
+
+int
+main(int argc, char **argv)
+{
+	int	i ;
+	int	seed0 = 1 ;
+	int	iterations = 100 ;
+	int	grow = 0 ;
+
+	topLevel = XtAppInitialize(&app_ctx, "Gridboxfuzz", NULL,0,
+		&argc,argv, NULL, NULL,0) ;
+	XtAppSetWarningHandler(app_ctx, warningHandler) ;
+
+	for(i=1; i < argc; ++i)
+	{
+	  if( strcmp(argv[i], "-s") == 0 && i+1 < argc )
+	    seed0 = atoi(argv[++i]) ;
+	  else if( strcmp(argv[i], "-i") == 0 && i+1 < argc )
+	    iterations = atoi(argv[++i]) ;
+	  else if( strcmp(argv[i], "-n") == 0 && i+1 < argc )
+	    maxChildren = atoi(argv[++i]) ;
+	  else if( strcmp(argv[i], "-g") == 0 )
+	    grow = 1 ;
+	  else if( strcmp(argv[i], "-v") == 0 )
+	    verbose = 1 ;
+	  else {
+	    fprintf(stderr,
+	      "usage: %s [-s seed] [-i iterations] [-n children] [-g] [-v]\n",
+	      argv[0]) ;
+	    exit(2) ;
+	  }
+	}
+
+	if( grow )
+	  growth(seed0) ;
+	else
+	  for(i=0; i < iterations; ++i)
+	    iterate(seed0 + i) ;
+
+	printf("%d failures\n", failures) ;
+	exit(failures ? 1 : 0) ;
+	/* NOTREACHED */
+}
+
+
+
+	/* One random grid, driven through NSTEPS random steps. */
+
+static	void
+iterate(s)
+	int	s ;
+{
+	Widget		shell, gb ;
+	int		i ;
+	double		t0 ;
+
+	seed = s ;
+	srand(seed) ;
+	if( verbose )
+	  printf("seed %d\n", seed) ;
+
+	shell = XtCreatePopupShell("fuzz", topLevelShellWidgetClass,
+		topLevel, NULL, 0) ;
+	gb = build(shell, 1 + rnd(maxChildren), rnd(8) == 0 ? 3 : 8, True) ;
+	XtPopup(shell, XtGrabNone) ;
+	flush() ;
+	check(gb, "first layout") ;
+
+	for(i=0; i < NSTEPS; ++i)
+	{
+	  t0 = now() ;
+	  randomStep(shell, gb) ;
+	  if( now() - t0 > MAX_STEP )
+	    fail("step %d took %.2f seconds", i, now() - t0) ;
+	}
+
+	checkRepeat(shell, gb) ;
+
+	XtDestroyWidget(shell) ;
+	flush() ;
+}
+
+
+	/* Build a Gridbox with n children in a grid about span cells on
+	 * a side.  With nest, one child in ten is a small Gridbox.
+	 */
+
+static	Widget
+build(parent, n, span, nest)
+	Widget	parent ;
+	int	n, span ;
+	Bool	nest ;
+{
+	Widget		gb, child ;
+	Arg		args[16] ;
+	Cardinal	na ;
+	char		name[32] ;
+	int		i ;
+
+	na = 0 ;
+	XtSetArg(args[na], XtNpublishLayout, True) ; ++na ;
+	XtSetArg(args[na], XtNdefaultDistance, rnd(5)) ; ++na ;
+	XtSetArg(args[na], XtNhomogeneous, rnd(8) == 0) ; ++na ;
+	gb = XtCreateManagedWidget("grid", gridboxWidgetClass, parent, args, na);
+
+	for(i=0; i < n; ++i)
+	{
+	  na = 0 ;
+	  XtSetArg(args[na], XtNgridx, rnd(span)) ; ++na ;
+	  XtSetArg(args[na], XtNgridy, rnd(span)) ; ++na ;
+	  XtSetArg(args[na], XtNgridWidth, rnd(4) ? 1 : 1+rnd(3)) ; ++na ;
+	  XtSetArg(args[na], XtNgridHeight, rnd(4) ? 1 : 1+rnd(3)) ; ++na ;
+	  XtSetArg(args[na], XtNweightx, rnd(3) ? 0 : rnd(4)) ; ++na ;
+	  XtSetArg(args[na], XtNweighty, rnd(3) ? 0 : rnd(4)) ; ++na ;
+	  XtSetArg(args[na], XtNmargin, rnd(4)) ; ++na ;
+	  XtSetArg(args[na], XtNfill, rnd(4)) ; ++na ;
+	  XtSetArg(args[na], XtNgravity, 1 + rnd(9)) ; ++na ;
+	  XtSetArg(args[na], XtNborderWidth, rnd(3)) ; ++na ;
+	  sprintf(name, "c%d", i) ;
+
+	  if( nest && rnd(10) == 0 )
+	  {
+	    child = XtCreateManagedWidget(name, gridboxWidgetClass, gb,
+			args, na) ;
+	    (void) build(child, 1 + rnd(4), 2, False) ;
+	  }
+	  else
+	  {
+	    XtSetArg(args[na], XtNwidth, 1 + rnd(100)) ; ++na ;
+	    XtSetArg(args[na], XtNheight, 1 + rnd(40)) ; ++na ;
+	    (void) XtCreateManagedWidget(name, widgetClass, gb, args, na) ;
+	  }
+	}
+
+	return gb ;
+}
+
+
+static	void
+randomStep(shell, gb)
+	Widget	shell, gb ;
+{
+	WidgetList	children ;
+	Cardinal	nchildren ;
+	Widget		child ;
+	char		what[64] ;
+
+	XtVaGetValues(gb, XtNchildren, &children,
+		XtNnumChildren, &nchildren, NULL) ;
+	child = children[rnd(nchildren)] ;
+
+	switch( rnd(5) ) {
+	  case 0:
+	    sprintf(what, "resize shell") ;
+	    XResizeWindow(XtDisplay(shell), XtWindow(shell),
+		1 + rnd(800), 1 + rnd(600)) ;
+	    break ;
+	  case 1:
+	    sprintf(what, "request from %s", XtName(child)) ;
+	    requestStep(child) ;
+	    break ;
+	  case 2:
+	    sprintf(what, "move %s", XtName(child)) ;
+	    XtVaSetValues(child, XtNgridx, rnd(8), XtNgridy, rnd(8), NULL) ;
+	    break ;
+	  case 3:
+	    sprintf(what, "reweight %s", XtName(child)) ;
+	    XtVaSetValues(child, XtNweightx, rnd(4), XtNfill, rnd(4),
+		XtNmargin, rnd(4), NULL) ;
+	    break ;
+	  case 4:
+	    sprintf(what, "%smanage %s", XtIsManaged(child) ? "un" : "",
+		XtName(child)) ;
+	    if( XtIsManaged(child) )
+	      XtUnmanageChild(child) ;
+	    else
+	      XtManageChild(child) ;
+	    break ;
+	}
+
+	if( verbose )
+	  printf("  %s\n", what) ;
+	flush() ;
+	check(gb, what) ;
+}
+
+
+	/* Ask for a new size, and accept any compromise, as most widgets
+	 * do.  The negotiation must settle within MAX_ROUNDS requests.
+	 */
+
+static	void
+requestStep(child)
+	Widget	child ;
+{
+	Dimension		width = 1 + rnd(150), height = 1 + rnd(60) ;
+	Dimension		rwidth, rheight ;
+	XtGeometryResult	result ;
+	int			rounds ;
+
+	for(rounds=1; ; ++rounds)
+	{
+	  result = XtMakeResizeRequest(child, width, height, &rwidth, &rheight);
+	  if( result != XtGeometryAlmost )
+	    break ;
+	  if( rounds >= MAX_ROUNDS ) {
+	    fail("request from %s not settled after %d rounds",
+		XtName(child), rounds) ;
+	    break ;
+	  }
+	  if( rwidth == width && rheight == height ) {
+	    fail("%s offered the compromise it was asked for",
+		XtName(XtParent(child))) ;
+	    break ;
+	  }
+	  width = rwidth ;
+	  height = rheight ;
+	}
+}
+
+
+	/* Check that every child lies within its cell.  A cell too small
+	 * to hold a one-pixel child is not checked.
+	 */
+
+static	void
+check(gb, what)
+	Widget	gb ;
+	char	*what ;
+{
+	GridboxLayout	*layout = GridboxGetLayout(gb) ;
+	XRectangle	*rect ;
+	Position	gx, gy ;
+	Dimension	gw, gh, bw ;
+	int		margin, edges ;
+	int		i, x0, x1, y0, y1 ;
+
+	if( warnings > 0 ) {
+	  fail("%d warnings after %s", warnings, what) ;
+	  warnings = 0 ;
+	}
+
+	if( layout == NULL )
+	  return ;
+
+	for(i=0; i < layout->nchildren; ++i)
+	{
+	  XtVaGetValues(layout->children[i], XtNgridx, &gx, XtNgridy, &gy,
+		XtNgridWidth, &gw, XtNgridHeight, &gh, XtNmargin, &margin,
+		XtNborderWidth, &bw, NULL) ;
+	  if( gx < 0 || gy < 0 || gx+gw > layout->nx || gy+gh > layout->ny )
+	    continue ;
+
+	  x0 = layout->col_x[gx] ;
+	  x1 = layout->col_x[gx+gw-1] + layout->col_width[gx+gw-1] ;
+	  y0 = layout->row_y[gy] ;
+	  y1 = layout->row_y[gy+gh-1] + layout->row_height[gy+gh-1] ;
+	  edges = 2*bw + 2*margin ;
+	  rect = &layout->rects[i] ;
+
+	  if( (x1-x0 > edges &&
+		(rect->x - margin < x0 ||
+		 rect->x + rect->width + 2*bw + margin > x1)) ||
+	      (y1-y0 > edges &&
+		(rect->y - margin < y0 ||
+		 rect->y + rect->height + 2*bw + margin > y1)) )
+	    fail("after %s, %s at %dx%d+%d+%d is outside cell %dx%d+%d+%d",
+		what, XtName(layout->children[i]),
+		rect->width, rect->height, rect->x, rect->y,
+		x1-x0, y1-y0, x0, y0) ;
+	}
+
+	GridboxReleaseLayout(layout) ;
+}
+
+
+	/* Resize the shell, resize it again, and return to the first
+	 * size; the first and last layouts must be the same.
+	 */
+
+static	void
+checkRepeat(shell, gb)
+	Widget	shell, gb ;
+{
+	Display		*dpy = XtDisplay(shell) ;
+	int		width = 100 + rnd(500), height = 100 + rnd(400) ;
+	GridboxLayout	*first, *last ;
+	int		i ;
+
+	XResizeWindow(dpy, XtWindow(shell), width, height) ;
+	flush() ;
+	first = GridboxGetLayout(gb) ;
+	XResizeWindow(dpy, XtWindow(shell), width/2 + 1, height*2) ;
+	flush() ;
+	XResizeWindow(dpy, XtWindow(shell), width, height) ;
+	flush() ;
+	last = GridboxGetLayout(gb) ;
+
+	if( first == NULL || last == NULL )
+	  ;
+	else if( first->nx != last->nx || first->ny != last->ny ||
+		 first->nchildren != last->nchildren )
+	  fail("layout at %dx%d changed shape on repeating", width, height) ;
+	else
+	{
+	  for(i=0; i < first->nx; ++i)
+	    if( first->col_width[i] != last->col_width[i] )
+	      fail("column %d at %dx%d was %d wide, then %d", i, width, height,
+		first->col_width[i], last->col_width[i]) ;
+	  for(i=0; i < first->ny; ++i)
+	    if( first->row_height[i] != last->row_height[i] )
+	      fail("row %d at %dx%d was %d high, then %d", i, width, height,
+		first->row_height[i], last->row_height[i]) ;
+	  for(i=0; i < first->nchildren; ++i)
+	    if( memcmp(&first->rects[i], &last->rects[i], sizeof(XRectangle)) )
+	      fail("%s at %dx%d moved on repeating",
+		XtName(first->children[i]), width, height) ;
+	}
+
+	if( first != NULL )
+	  GridboxReleaseLayout(first) ;
+	if( last != NULL )
+	  GridboxReleaseLayout(last) ;
+}
+
+
+
+	/* Growth test.  Time the first layout and a resize drag of random
+	 * grids, doubling the number of children each time.  Layout should
+	 * be roughly linear in the number of children.
+	 */
+
+static	void
+growth(s)
+	int	s ;
+{
+	Widget		shell ;
+	Display		*dpy = XtDisplay(topLevel) ;
+	Dimension	width, height ;
+	int		n, span, i ;
+	double		t0, t, last = 0. ;
+
+	printf("%8s %12s %12s\n", "children", "seconds", "usec/child") ;
+
+	for(n=250; n <= 8000; n *= 2)
+	{
+	  seed = s ;
+	  srand(seed) ;
+	  for(span=1; span*span < n; ++span) ;
+
+	  shell = XtCreatePopupShell("fuzz", topLevelShellWidgetClass,
+		topLevel, NULL, 0) ;
+	  t0 = now() ;
+	  (void) build(shell, n, span, False) ;
+	  XtPopup(shell, XtGrabNone) ;
+	  flush() ;
+	  XtVaGetValues(shell, XtNwidth, &width, XtNheight, &height, NULL) ;
+	  for(i=1; i <= 20; ++i) {
+	    XResizeWindow(dpy, XtWindow(shell), width + 8*i, height + 4*i) ;
+	    flush() ;
+	  }
+	  t = now() - t0 ;
+
+	  printf("%8d %12.3f %12.1f\n", n, t, t * 1e6 / n) ;
+	  if( last > 0. && t > 3. * last )
+	    fail("%d children took %.1f times as long as %d",
+		n, t / last, n/2) ;
+	  last = t ;
+
+	  XtDestroyWidget(shell) ;
+	  flush() ;
+	}
+}
+
+
+
+	/* Report a failure, with the seed which reproduces it. */
+
+static	void
+fail(char *fmt, ...)
+{
+	va_list	ap ;
+
+	printf("seed %d: ", seed) ;
+	va_start(ap, fmt) ;
+	vprintf(fmt, ap) ;
+	va_end(ap) ;
+	printf("\n") ;
+	++failures ;
+}
+
+
+	/* Wait for the server, and handle everything it sent back. */
+
+static	void
+flush()
+{
+	XSync(XtDisplay(topLevel), False) ;
+	while( XtAppPending(app_ctx) )
+	  XtAppProcessEvent(app_ctx, XtIMAll) ;
+}
+
+
+static	void
+warningHandler(msg)
+	String	msg ;
+{
+	printf("seed %d: warning: %s\n", seed, msg) ;
+	++warnings ;
+}
+
+
+static	int
+rnd(n)
+	int	n ;
+{
+	return n > 0 ? rand() % n : 0 ;
+}
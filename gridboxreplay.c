@@ -0,0 +1,572 @@
+static	char	rcsid[] = "$Id$" ;
+
+/*
+ * gridboxreplay - play back a Gridbox trace file and time each event.
+ *
+ * usage:  gridboxreplay [-v] tracefile
+ *
+ * A trace is written by any Gridbox whose traceFile resource is set.
+ * It records the Gridboxes' sizes, their children's constraints and
+ * preferred sizes, and every change-managed, geometry request, query,
+ * resize and constraint change, in order.
+ *
+ * gridboxreplay rebuilds the Gridboxes, with Core widgets standing in for
+ * the other children, and drives them through the same sequence of
+ * events.  Events which happened inside other events (e.g. a nested
+ * Gridbox's geometry request during its parent's resize) are not played
+ * directly; they follow from the outer event as they did originally.
+ *
+ * When done, the number of events of each type, and the mean and maximum
+ * time taken by the replay and by the original are printed.  With -v,
+ * every event is printed as it is played.  Geometry requests and queries
+ * whose results differ from the original are counted as mismatches.
+ *
+ * Run this under Xvfb to replay traces from the field on a build machine.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <X11/StringDefs.h>
+#include <X11/Intrinsic.h>
+#include <X11/Core.h>
+#include <X11/Shell.h>
+
+#include "GridboxP.h"
+
+	/* Xt stuff */
+
+static	XtAppContext	app_ctx ;
+static	Widget		topLevel ;
+
+	/* One Gridbox from the trace */
+
+typedef	struct {
+	Widget	w ;
+	Widget	shell ;		/* NULL unless top-level in the trace */
+	Widget	*children ;	/* indexed as in the original */
+	int	nchildren ;
+} Box ;
+
+static	Box	*boxes = NULL ;
+static	int	nboxes = 0 ;
+
+	/* Per event type statistics */
+
+typedef	struct {
+	char	*name ;
+	int	count ;
+	int	mismatches ;
+	double	total, max ;		/* replay, usec */
+	double	rtotal, rmax ;		/* original, usec */
+} Stat ;
+
+static	Stat	stats[] = {
+	{"(none)"}, {"create"}, {"change managed"}, {"child"},
+	{"geometry request"}, {"reply"}, {"query geometry"},
+	{"resize"}, {"constraint change"}, {"destroy"},
+} ;
+
+static	int	verbose = 0 ;
+static	int	nested = 0 ;
+static	FILE	*trace ;
+
+
+static	int	readRecord() ;
+static	Box	*getBox() ;
+static	void	growChildren() ;
+static	Widget	getChild() ;
+static	int	childArgs() ;
+static	void	doCreate() ;
+static	void	doManaged() ;
+static	void	doRequest() ;
+static	void	doQuery() ;
+static	void	doResize() ;
+static	void	doConstraint() ;
+static	void	doDestroy() ;
+static	void	record() ;
+static	void	report() ;
+
+
+static	double
+now()
+{
+	struct timeval	tv ;
+
+	gettimeofday(&tv, NULL) ;
+	return tv.tv_sec * 1e6 + tv.tv_usec ;
+}
+
+
+int
+main(int argc, char **argv)
+{
+	GridboxTraceRecord	rec ;
+	INT32			args[256] ;
+	CARD32			magic ;
+	char			*filename = NULL ;
+	int			i ;
+
+	topLevel = XtAppInitialize(&app_ctx, "Gridboxreplay", NULL,0,
+		&argc,argv, NULL, NULL,0) ;
+
+	for(i=1; i < argc; ++i)
+	{
+	  if( strcmp(argv[i], "-v") == 0 )
+	    verbose = 1 ;
+	  else if( filename == NULL && argv[i][0] != '-' )
+	    filename = argv[i] ;
+	  else
+	    filename = NULL, i = argc ;
+	}
+
+	if( filename == NULL ) {
+	  fprintf(stderr, "usage: %s [-v] tracefile\n", argv[0]) ;
+	  exit(2) ;
+	}
+
+	if( (trace = fopen(filename, "rb")) == NULL ) {
+	  perror(filename) ;
+	  exit(1) ;
+	}
+
+	if( fread(&magic, sizeof(magic), 1, trace) != 1 || magic != GBT_MAGIC ) {
+	  fprintf(stderr, "%s: not a Gridbox trace file\n", filename) ;
+	  exit(1) ;
+	}
+
+	while( readRecord(&rec, args) )
+	{
+	  if( rec.depth > 0 ) {
+	    ++nested ;
+	    continue ;
+	  }
+
+	  switch( rec.type ) {
+	    case GBT_CREATE: doCreate(&rec, args) ; break ;
+	    case GBT_MANAGED: doManaged(&rec, args) ; break ;
+	    case GBT_REQUEST: doRequest(&rec, args) ; break ;
+	    case GBT_QUERY: doQuery(&rec, args) ; break ;
+	    case GBT_RESIZE: doResize(&rec, args) ; break ;
+	    case GBT_CONSTRAINT: doConstraint(&rec, args) ; break ;
+	    case GBT_DESTROY: doDestroy(&rec, args) ; break ;
+	    default: break ;		/* stray GBT_CHILD or GBT_REPLY */
+	  }
+	}
+
+	fclose(trace) ;
+	report() ;
+
+	exit(0) ;
+	/* NOTREACHED */
+}
+
+
+
+static	int
+readRecord(rec, args)
+	GridboxTraceRecord	*rec ;
+	INT32			*args ;
+{
+	if( fread(rec, sizeof(*rec), 1, trace) != 1 )
+	  return 0 ;
+	if( rec->type == 0 || rec->type >= XtNumber(stats) ||
+	    fread(args, sizeof(INT32), rec->nargs, trace) != rec->nargs )
+	{
+	  fprintf(stderr, "gridboxreplay: trace file truncated or corrupt\n") ;
+	  return 0 ;
+	}
+	return 1 ;
+}
+
+
+static	Box *
+getBox(id)
+	int	id ;
+{
+	if( id >= nboxes )
+	{
+	  boxes = (Box *) XtRealloc((char *)boxes, (id+1) * sizeof(Box)) ;
+	  memset(boxes+nboxes, 0, (id+1-nboxes) * sizeof(Box)) ;
+	  nboxes = id+1 ;
+	}
+	return &boxes[id] ;
+}
+
+
+static	void
+growChildren(box, idx)
+	Box	*box ;
+	int	idx ;
+{
+	if( idx >= box->nchildren )
+	{
+	  box->children = (Widget *) XtRealloc((char *)box->children,
+		(idx+1) * sizeof(Widget)) ;
+	  memset(box->children+box->nchildren, 0,
+		(idx+1-box->nchildren) * sizeof(Widget)) ;
+	  box->nchildren = idx+1 ;
+	}
+}
+
+
+	/* Return the child at the given index, creating a Core widget
+	 * in its place if there isn't one yet.
+	 */
+
+static	Widget
+getChild(box, idx)
+	Box	*box ;
+	int	idx ;
+{
+	char	name[32] ;
+
+	if( idx == GBT_NONE || box->w == NULL )
+	  return NULL ;
+
+	growChildren(box, idx) ;
+	if( box->children[idx] == NULL ) {
+	  sprintf(name, "c%d", idx) ;
+	  box->children[idx] = XtVaCreateWidget(name, widgetClass, box->w,
+		XtNwidth, 1, XtNheight, 1, NULL) ;
+	}
+	return box->children[idx] ;
+}
+
+
+	/* Fill in an arg list from a GBT_CHILD or GBT_CONSTRAINT record. */
+
+static	int
+childArgs(args, wargs)
+	INT32	*args ;
+	Arg	*wargs ;
+{
+	XtSetArg(wargs[0], XtNgridx, (Position)args[0]) ;
+	XtSetArg(wargs[1], XtNgridy, (Position)args[1]) ;
+	XtSetArg(wargs[2], XtNgridWidth, (Dimension)args[2]) ;
+	XtSetArg(wargs[3], XtNgridHeight, (Dimension)args[3]) ;
+	XtSetArg(wargs[4], XtNfill, (FillType)args[4]) ;
+	XtSetArg(wargs[5], XtNgravity, args[5]) ;
+	XtSetArg(wargs[6], XtNweightx, args[6]) ;
+	XtSetArg(wargs[7], XtNweighty, args[7]) ;
+	XtSetArg(wargs[8], XtNmargin, args[8]) ;
+	XtSetArg(wargs[9], XtNallowResize, (Boolean)args[9]) ;
+	return 10 ;
+}
+
+
+
+static	void
+doCreate(rec, args)
+	GridboxTraceRecord	*rec ;
+	INT32			*args ;
+{
+	Box	*box = getBox(rec->gridbox) ;
+	Widget	parent ;
+	char	name[32] ;
+
+	sprintf(name, "gridbox%d", rec->gridbox) ;
+
+	if( args[0] == GBT_NONE ) {
+	  box->shell = XtAppCreateShell(name, "Gridboxreplay",
+		applicationShellWidgetClass, XtDisplay(topLevel), NULL,0) ;
+	  parent = box->shell ;
+	}
+	else
+	  parent = getBox(args[0])->w ;
+
+	box->w = XtVaCreateWidget(name, gridboxWidgetClass, parent,
+		XtNwidth, args[2] > 0 ? args[2] : 1,
+		XtNheight, args[3] > 0 ? args[3] : 1,
+		XtNdefaultDistance, args[4],
+		XtNhomogeneous, (Boolean)args[5],
+		NULL) ;
+
+	/* Put the new Gridbox where its parent's records expect it */
+	if( args[0] != GBT_NONE ) {
+	  Box	*pbox = getBox(args[0]) ;
+	  growChildren(pbox, args[1]) ;
+	  pbox->children[args[1]] = box->w ;
+	}
+
+	record(rec, 0., -1., 0) ;
+}
+
+
+
+	/* Set up the children listed in the following GBT_CHILD records,
+	 * then manage and unmanage children to match, and time that.
+	 */
+
+static	void
+doManaged(rec, args)
+	GridboxTraceRecord	*rec ;
+	INT32			*args ;
+{
+	Box			*box = getBox(rec->gridbox) ;
+	GridboxTraceRecord	crec ;
+	INT32			cargs[256] ;
+	Arg			wargs[16] ;
+	WidgetList		manage, unmanage ;
+	int			nmanage = 0, nunmanage = 0 ;
+	char			*listed ;
+	Widget			child ;
+	int			i, n ;
+	double			t0 ;
+
+	n = args[0] ;
+	manage = (WidgetList) XtMalloc((n+1) * sizeof(Widget)) ;
+
+	for(i=0; i < n && readRecord(&crec, cargs); ++i)
+	{
+	  if( crec.type != GBT_CHILD || crec.child == GBT_NONE )
+	    break ;
+	  child = getChild(box, crec.child) ;
+	  if( !XtIsManaged(child) )
+	  {
+	    int nargs = childArgs(cargs, wargs) ;
+	    if( !XtIsSubclass(child, gridboxWidgetClass) ) {
+	      XtSetArg(wargs[nargs], XtNwidth, cargs[10] > 0 ? cargs[10] : 1) ;
+	      ++nargs ;
+	      XtSetArg(wargs[nargs], XtNheight, cargs[11] > 0 ? cargs[11] : 1) ;
+	      ++nargs ;
+	    }
+	    XtSetArg(wargs[nargs], XtNborderWidth, cargs[12]) ; ++nargs ;
+	    XtSetValues(child, wargs, nargs) ;
+	    manage[nmanage++] = child ;
+	  }
+	}
+
+	/* Anything managed now but not listed is to be unmanaged */
+	listed = XtCalloc(box->nchildren+1, 1) ;
+	for(i=0; i < nmanage; ++i) {
+	  int j ;
+	  for(j=0; j < box->nchildren; ++j)
+	    if( box->children[j] == manage[i] )
+	      listed[j] = 1 ;
+	}
+	unmanage = (WidgetList) XtMalloc((box->nchildren+1) * sizeof(Widget)) ;
+	for(i=0; i < box->nchildren; ++i)
+	  if( !listed[i] && box->children[i] != NULL &&
+	      XtIsManaged(box->children[i]) )
+	    unmanage[nunmanage++] = box->children[i] ;
+
+	t0 = now() ;
+	if( nunmanage > 0 )
+	  XtUnmanageChildren(unmanage, nunmanage) ;
+	if( nmanage > 0 )
+	  XtManageChildren(manage, nmanage) ;
+	if( box->shell != NULL && !XtIsManaged(box->w) )
+	  XtManageChild(box->w) ;
+	record(rec, now() - t0, (double)args[1], 0) ;
+
+	if( box->shell != NULL && !XtIsRealized(box->shell) )
+	  XtRealizeWidget(box->shell) ;
+
+	XtFree((char *)manage) ;
+	XtFree((char *)unmanage) ;
+	XtFree(listed) ;
+}
+
+
+
+	/* Replay a child's geometry request; the reply record follows. */
+
+static	void
+doRequest(rec, args)
+	GridboxTraceRecord	*rec ;
+	INT32			*args ;
+{
+	Widget			child = getChild(getBox(rec->gridbox), rec->child) ;
+	XtWidgetGeometry	request, reply ;
+	XtGeometryResult	result ;
+	GridboxTraceRecord	rrec ;
+	INT32			rargs[256] ;
+	double			t0, t ;
+
+	if( child == NULL )
+	  return ;
+
+	request.request_mode = args[0] ;
+	request.x = args[1] ;
+	request.y = args[2] ;
+	request.width = args[3] ;
+	request.height = args[4] ;
+	request.border_width = args[5] ;
+
+	t0 = now() ;
+	result = XtMakeGeometryRequest(child, &request, &reply) ;
+	t = now() - t0 ;
+
+	/* find the matching reply, skipping nested events */
+	while( readRecord(&rrec, rargs) )
+	  if( rrec.type == GBT_REPLY && rrec.depth == rec->depth &&
+	      rrec.gridbox == rec->gridbox )
+	  {
+	    record(rec, t, (double)rargs[4], result != rargs[0]) ;
+	    return ;
+	  }
+	  else
+	    ++nested ;
+
+	record(rec, t, -1., 0) ;
+}
+
+
+
+static	void
+doQuery(rec, args)
+	GridboxTraceRecord	*rec ;
+	INT32			*args ;
+{
+	Box			*box = getBox(rec->gridbox) ;
+	XtWidgetGeometry	request, reply ;
+	XtGeometryResult	result ;
+	double			t0 ;
+
+	if( box->w == NULL )
+	  return ;
+
+	request.request_mode = args[0] ;
+	request.width = args[1] ;
+	request.height = args[2] ;
+
+	t0 = now() ;
+	result = XtQueryGeometry(box->w, &request, &reply) ;
+	record(rec, now() - t0, (double)args[6],
+	  result != args[3] ||
+	  reply.width != args[4] || reply.height != args[5]) ;
+}
+
+
+
+static	void
+doResize(rec, args)
+	GridboxTraceRecord	*rec ;
+	INT32			*args ;
+{
+	Box	*box = getBox(rec->gridbox) ;
+	double	t0 ;
+
+	if( box->w == NULL )
+	  return ;
+
+	t0 = now() ;
+	XtResizeWidget(box->w, args[0] > 0 ? args[0] : 1,
+	  args[1] > 0 ? args[1] : 1, box->w->core.border_width) ;
+	record(rec, now() - t0, (double)args[2], 0) ;
+}
+
+
+
+static	void
+doConstraint(rec, args)
+	GridboxTraceRecord	*rec ;
+	INT32			*args ;
+{
+	Widget	child = getChild(getBox(rec->gridbox), rec->child) ;
+	Arg	wargs[16] ;
+	int	nargs ;
+	double	t0 ;
+
+	if( child == NULL )
+	  return ;
+
+	nargs = childArgs(args, wargs) ;
+	t0 = now() ;
+	XtSetValues(child, wargs, nargs) ;
+	record(rec, now() - t0, -1., 0) ;
+}
+
+
+
+static	void
+doDestroy(rec, args)
+	GridboxTraceRecord	*rec ;
+	INT32			*args ;
+{
+	Box	*box = getBox(rec->gridbox) ;
+	double	t0 ;
+	int	i, j ;
+
+	if( box->w == NULL )
+	  return ;
+
+	t0 = now() ;
+	XtDestroyWidget(box->shell != NULL ? box->shell : box->w) ;
+	record(rec, now() - t0, -1., 0) ;
+
+	/* forget it in its parent */
+	for(i=0; i < nboxes; ++i)
+	  for(j=0; j < boxes[i].nchildren; ++j)
+	    if( boxes[i].children[j] == box->w )
+	      boxes[i].children[j] = NULL ;
+
+	XtFree((char *)box->children) ;
+	box->children = NULL ;
+	box->nchildren = 0 ;
+	box->w = box->shell = NULL ;
+}
+
+
+
+	/* Accumulate statistics for one event.  orig < 0 means the
+	 * original time was not recorded.
+	 */
+
+static	void
+record(rec, usec, orig, mismatch)
+	GridboxTraceRecord	*rec ;
+	double			usec, orig ;
+	int			mismatch ;
+{
+	Stat	*stat = &stats[rec->type] ;
+
+	++stat->count ;
+	stat->total += usec ;
+	if( usec > stat->max )
+	  stat->max = usec ;
+	if( orig >= 0. ) {
+	  stat->rtotal += orig ;
+	  if( orig > stat->rmax )
+	    stat->rmax = orig ;
+	}
+	if( mismatch )
+	  ++stat->mismatches ;
+
+	if( verbose )
+	{
+	  printf("%10lu %-20s gridbox %d", (unsigned long)rec->time,
+	    stat->name, rec->gridbox) ;
+	  if( rec->child != GBT_NONE )
+	    printf(" child %d", rec->child) ;
+	  printf(": %.1f usec", usec) ;
+	  if( orig >= 0. )
+	    printf(" (was %.0f)", orig) ;
+	  if( mismatch )
+	    printf(" MISMATCH") ;
+	  putchar('\n') ;
+	}
+}
+
+
+static	void
+report()
+{
+	Stat	*stat ;
+	int	i ;
+
+	printf("%-20s %8s %10s %10s %10s %10s %6s\n", "event", "count",
+	  "mean", "max", "orig mean", "orig max", "diffs") ;
+
+	for(i=1, stat = stats+1; i < XtNumber(stats); ++i, ++stat)
+	  if( stat->count > 0 )
+	    printf("%-20s %8d %10.1f %10.1f %10.1f %10.1f %6d\n",
+	      stat->name, stat->count,
+	      stat->total / stat->count, stat->max,
+	      stat->rtotal / stat->count, stat->rmax, stat->mismatches) ;
+
+	printf("%d nested events not replayed directly\n", nested) ;
+}
@@ -0,0 +1,402 @@
+static	char	rcsid[] = "$Id$" ;
+
+/*
+ * gridboxstress - lay out Gridboxes in several threads at once.
+ *
+ * usage:  gridboxstress [-display name] [-t threads] [-i iterations]
+ *		[-n children] [-s seed] [-v]
+ *
+ * After XtToolkitThreadInitialize(), each thread (default 4) opens its
+ * own display connection in its own application context, and builds
+ * and resizes random grids of up to the given number of children
+ * (default 40), with child geometry requests in between.  Every thread
+ * builds the same grids, iteration i from seed+i, but each starts at a
+ * different iteration, so different grids are laid out at the same
+ * time.  After each step, every child must lie within the Gridbox;
+ * at the end of each grid, the layout at a fixed size is summarized in
+ * a checksum, and once all threads are done, the checksums of the same
+ * grid must agree between threads.  Gridbox must issue no warnings.
+ *
+ * A failure here but not in gridboxfuzz points to state shared
+ * between Gridboxes in different application contexts.
+ *
+ * Run this under Xvfb, with no window manager.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+
+#include <X11/Xlib.h>
+#include <X11/StringDefs.h>
+#include <X11/Intrinsic.h>
+#include <X11/Core.h>
+#include <X11/Shell.h>
+
+#include "Gridbox.h"
+
+#define	MAX_THREADS	64
+#define	NSTEPS		40	/* resizes and requests per grid */
+#define	CHECK_WIDTH	400	/* size for the layout checksum */
+#define	CHECK_HEIGHT	300
+
+typedef	struct {
+	int		id ;
+	pthread_t	thread ;
+	unsigned int	rand_state ;
+	XtAppContext	app_ctx ;
+	Display		*dpy ;
+	Widget		topLevel ;
+	unsigned long	*sums ;		/* layout checksum per iteration */
+	int		failures ;
+} Stress ;
+
+static	char	*displayName = NULL ;
+static	int	nthreads = 4 ;
+static	int	iterations = 20 ;
+static	int	maxChildren = 40 ;
+static	int	seed0 = 1 ;
+static	int	verbose = 0 ;
+
+static	pthread_mutex_t	outputLock = PTHREAD_MUTEX_INITIALIZER ;
+static	int		warnings = 0 ;
+
+
+static	void	*stress() ;
+static	Widget	build() ;
+static	void	step() ;
+static	void	check() ;
+static	unsigned long	checksum() ;
+static	void	fail(Stress *, char *, ...) ;
+static	void	flush() ;
+static	void	warningHandler() ;
+static	int	rnd() ;
+
+
+int
+main(int argc, char **argv)
+{
+	Stress	*threads ;
+	int	i, t ;
+	int	failures = 0 ;
+
+	for(i=1; i < argc; ++i)
+	{
+	  if( strcmp(argv[i], "-display") == 0 && i+1 < argc )
+	    displayName = argv[++i] ;
+	  else if( strcmp(argv[i], "-t") == 0 && i+1 < argc )
+	    nthreads = atoi(argv[++i]) ;
+	  else if( strcmp(argv[i], "-i") == 0 && i+1 < argc )
+	    iterations = atoi(argv[++i]) ;
+	  else if( strcmp(argv[i], "-n") == 0 && i+1 < argc )
+	    maxChildren = atoi(argv[++i]) ;
+	  else if( strcmp(argv[i], "-s") == 0 && i+1 < argc )
+	    seed0 = atoi(argv[++i]) ;
+	  else if( strcmp(argv[i], "-v") == 0 )
+	    verbose = 1 ;
+	  else {
+	    fprintf(stderr, "usage: %s [-display name] [-t threads] "
+		"[-i iterations] [-n children] [-s seed] [-v]\n", argv[0]) ;
+	    exit(2) ;
+	  }
+	}
+	if( nthreads < 1 || nthreads > MAX_THREADS || iterations < 1 ) {
+	  fprintf(stderr, "%s: 1 to %d threads, at least 1 iteration\n",
+		argv[0], MAX_THREADS) ;
+	  exit(2) ;
+	}
+
+	if( !XInitThreads() || !XtToolkitThreadInitialize() ) {
+	  fprintf(stderr, "%s: Xlib or Xt not built with thread support\n",
+		argv[0]) ;
+	  exit(2) ;
+	}
+
+	threads = (Stress *) calloc(nthreads, sizeof(Stress)) ;
+	for(t=0; t < nthreads; ++t)
+	{
+	  threads[t].id = t ;
+	  threads[t].sums =
+		(unsigned long *) calloc(iterations, sizeof(unsigned long)) ;
+	  if( pthread_create(&threads[t].thread, NULL, stress, &threads[t]) ) {
+	    perror("pthread_create") ;
+	    exit(2) ;
+	  }
+	}
+	for(t=0; t < nthreads; ++t)
+	  pthread_join(threads[t].thread, NULL) ;
+
+	for(t=0; t < nthreads; ++t)
+	{
+	  failures += threads[t].failures ;
+	  for(i=0; t > 0 && i < iterations; ++i)
+	    if( threads[t].sums[i] != threads[0].sums[i] ) {
+	      printf("seed %d: thread %d laid out the grid differently "
+		"from thread 0\n", seed0 + i, t) ;
+	      ++failures ;
+	    }
+	}
+	if( warnings > 0 ) {
+	  printf("%d warnings\n", warnings) ;
+	  failures += warnings ;
+	}
+
+	printf("%d failures\n", failures) ;
+	exit(failures ? 1 : 0) ;
+	/* NOTREACHED */
+}
+
+
+
+	/* One thread:  open a display in a new application context, and
+	 * run every iteration, starting at one of its own.
+	 */
+
+static	void *
+stress(arg)
+	void	*arg ;
+{
+	Stress		*s = (Stress *) arg ;
+	int		argc = 0 ;
+	int		i, j, it ;
+	Widget		shell, gb ;
+
+	s->app_ctx = XtCreateApplicationContext() ;
+	XtAppSetWarningHandler(s->app_ctx, warningHandler) ;
+	s->dpy = XtOpenDisplay(s->app_ctx, displayName, "gridboxstress",
+		"Gridboxstress", NULL,0, &argc, NULL) ;
+	if( s->dpy == NULL ) {
+	  fail(s, "cannot open display") ;
+	  return NULL ;
+	}
+	s->topLevel = XtAppCreateShell("gridboxstress", "Gridboxstress",
+		applicationShellWidgetClass, s->dpy, NULL, 0) ;
+
+	for(i=0; i < iterations; ++i)
+	{
+	  it = (i + s->id * iterations / nthreads) % iterations ;
+	  s->rand_state = seed0 + it ;
+	  if( verbose ) {
+	    pthread_mutex_lock(&outputLock) ;
+	    printf("thread %d: seed %d\n", s->id, seed0 + it) ;
+	    pthread_mutex_unlock(&outputLock) ;
+	  }
+
+	  shell = XtCreatePopupShell("stress", topLevelShellWidgetClass,
+		s->topLevel, NULL, 0) ;
+	  gb = build(s, shell, 1 + rnd(s, maxChildren), 8, True) ;
+	  XtPopup(shell, XtGrabNone) ;
+	  flush(s) ;
+	  check(s, gb, it) ;
+
+	  for(j=0; j < NSTEPS; ++j) {
+	    step(s, shell, gb) ;
+	    check(s, gb, it) ;
+	  }
+
+	  XResizeWindow(s->dpy, XtWindow(shell), CHECK_WIDTH, CHECK_HEIGHT) ;
+	  flush(s) ;
+	  s->sums[it] = checksum(gb) ;
+
+	  XtDestroyWidget(shell) ;
+	  flush(s) ;
+	}
+
+	XtDestroyApplicationContext(s->app_ctx) ;
+	return NULL ;
+}
+
+
+	/* Build a Gridbox with n children in a grid about span cells on
+	 * a side.  With nest, one child in ten is a small Gridbox.
+	 */
+
+static	Widget
+build(s, parent, n, span, nest)
+	Stress	*s ;
+	Widget	parent ;
+	int	n, span ;
+	Bool	nest ;
+{
+	Widget		gb, child ;
+	Arg		args[16] ;
+	Cardinal	na ;
+	char		name[32] ;
+	int		i ;
+
+	na = 0 ;
+	XtSetArg(args[na], XtNpublishLayout, True) ; ++na ;
+	XtSetArg(args[na], XtNdefaultDistance, rnd(s, 5)) ; ++na ;
+	gb = XtCreateManagedWidget("grid", gridboxWidgetClass, parent, args, na);
+
+	for(i=0; i < n; ++i)
+	{
+	  na = 0 ;
+	  XtSetArg(args[na], XtNgridx, rnd(s, span)) ; ++na ;
+	  XtSetArg(args[na], XtNgridy, rnd(s, span)) ; ++na ;
+	  XtSetArg(args[na], XtNgridWidth, rnd(s, 4) ? 1 : 1+rnd(s, 3)) ; ++na ;
+	  XtSetArg(args[na], XtNweightx, rnd(s, 3) ? 0 : rnd(s, 4)) ; ++na ;
+	  XtSetArg(args[na], XtNweighty, rnd(s, 3) ? 0 : rnd(s, 4)) ; ++na ;
+	  XtSetArg(args[na], XtNfill, rnd(s, 4)) ; ++na ;
+	  XtSetArg(args[na], XtNgravity, 1 + rnd(s, 9)) ; ++na ;
+	  sprintf(name, "c%d", i) ;
+
+	  if( nest && rnd(s, 10) == 0 )
+	  {
+	    child = XtCreateManagedWidget(name, gridboxWidgetClass, gb,
+			args, na) ;
+	    (void) build(s, child, 1 + rnd(s, 4), 2, False) ;
+	  }
+	  else
+	  {
+	    XtSetArg(args[na], XtNwidth, 1 + rnd(s, 100)) ; ++na ;
+	    XtSetArg(args[na], XtNheight, 1 + rnd(s, 40)) ; ++na ;
+	    (void) XtCreateManagedWidget(name, widgetClass, gb, args, na) ;
+	  }
+	}
+
+	return gb ;
+}
+
+
+	/* Resize the shell, or have a child ask for a new size */
+
+static	void
+step(s, shell, gb)
+	Stress	*s ;
+	Widget	shell, gb ;
+{
+	WidgetList	children ;
+	Cardinal	nchildren ;
+	Widget		child ;
+	Dimension	width, height ;
+
+	if( rnd(s, 2) == 0 )
+	  XResizeWindow(s->dpy, XtWindow(shell),
+		1 + rnd(s, 800), 1 + rnd(s, 600)) ;
+	else
+	{
+	  XtVaGetValues(gb, XtNchildren, &children,
+		XtNnumChildren, &nchildren, NULL) ;
+	  child = children[rnd(s, nchildren)] ;
+	  (void) XtMakeResizeRequest(child, 1 + rnd(s, 150), 1 + rnd(s, 60),
+		&width, &height) ;
+	}
+	flush(s) ;
+}
+
+
+	/* Every child must lie within the cells of the Gridbox.  A grid
+	 * too small to hold its children is not checked.
+	 */
+
+static	void
+check(s, gb, it)
+	Stress	*s ;
+	Widget	gb ;
+	int	it ;
+{
+	GridboxLayout	*layout = GridboxGetLayout(gb) ;
+	XRectangle	*rect ;
+	int		i, width, height ;
+
+	if( layout == NULL || layout->nx == 0 || layout->ny == 0 ) {
+	  if( layout != NULL )
+	    GridboxReleaseLayout(layout) ;
+	  return ;
+	}
+
+	width = layout->col_x[layout->nx-1] + layout->col_width[layout->nx-1];
+	height = layout->row_y[layout->ny-1] + layout->row_height[layout->ny-1];
+	for(i=0; i < layout->nchildren; ++i)
+	{
+	  rect = &layout->rects[i] ;
+	  if( rect->x < 0 || rect->y < 0 ||
+	      (rect->width > 1 && rect->x + rect->width > width) ||
+	      (rect->height > 1 && rect->y + rect->height > height) )
+	    fail(s, "seed %d: %s at %dx%d+%d+%d is outside the %dx%d grid",
+		seed0 + it, XtName(layout->children[i]),
+		rect->width, rect->height, rect->x, rect->y, width, height) ;
+	}
+
+	GridboxReleaseLayout(layout) ;
+}
+
+
+	/* Summarize the cells and children of a layout */
+
+static	unsigned long
+checksum(gb)
+	Widget	gb ;
+{
+	GridboxLayout	*layout = GridboxGetLayout(gb) ;
+	unsigned long	sum = 0 ;
+	int		i ;
+
+	if( layout == NULL )
+	  return 0 ;
+
+	for(i=0; i < layout->nx; ++i)
+	  sum = sum * 31 + layout->col_x[i] * 7 + layout->col_width[i] ;
+	for(i=0; i < layout->ny; ++i)
+	  sum = sum * 31 + layout->row_y[i] * 7 + layout->row_height[i] ;
+	for(i=0; i < layout->nchildren; ++i)
+	  sum = sum * 31 + layout->rects[i].x * 7 + layout->rects[i].y * 5 +
+		layout->rects[i].width * 3 + layout->rects[i].height ;
+
+	GridboxReleaseLayout(layout) ;
+	return sum ;
+}
+
+
+
+	/* Report a failure in one thread. */
+
+static	void
+fail(Stress *s, char *fmt, ...)
+{
+	va_list	ap ;
+
+	pthread_mutex_lock(&outputLock) ;
+	printf("thread %d: ", s->id) ;
+	va_start(ap, fmt) ;
+	vprintf(fmt, ap) ;
+	va_end(ap) ;
+	printf("\n") ;
+	pthread_mutex_unlock(&outputLock) ;
+	++s->failures ;
+}
+
+
+	/* Wait for the server, and handle everything it sent back. */
+
+static	void
+flush(s)
+	Stress	*s ;
+{
+	XSync(s->dpy, False) ;
+	while( XtAppPending(s->app_ctx) )
+	  XtAppProcessEvent(s->app_ctx, XtIMAll) ;
+}
+
+
+static	void
+warningHandler(msg)
+	String	msg ;
+{
+	pthread_mutex_lock(&outputLock) ;
+	printf("warning: %s\n", msg) ;
+	++warnings ;
+	pthread_mutex_unlock(&outputLock) ;
+}
+
+
+static	int
+rnd(s, n)
+	Stress	*s ;
+	int	n ;
+{
+	return n > 0 ? rand_r(&s->rand_state) % n : 0 ;
+}